@@ -0,0 +1,24 @@
+# deception_generate_interpreter(<target> DESCRIPTION <file> [NAMESPACE <name>] [SOURCES <source>...])
+#
+# Generate a C++ interpreter from a conclave description with deception-codegen and build it as an executable linked
+# against deception-core. Anything named by call in the description which is not a builtin goes in SOURCES.
+function(deception_generate_interpreter target)
+    cmake_parse_arguments(ARG "" "DESCRIPTION;NAMESPACE" "SOURCES" ${ARGN})
+    if (NOT ARG_DESCRIPTION)
+        message(FATAL_ERROR "deception_generate_interpreter: ${target} needs a DESCRIPTION")
+    endif()
+    if (NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE Generated)
+    endif()
+    get_filename_component(description ${ARG_DESCRIPTION} ABSOLUTE)
+    set(generated ${CMAKE_CURRENT_BINARY_DIR}/${target}.generated.cc)
+    add_custom_command(
+            OUTPUT ${generated}
+            COMMAND deception-codegen --namespace ${ARG_NAMESPACE} -o ${generated} ${description}
+            DEPENDS deception-codegen ${description}
+            COMMENT "Generating ${target} from ${ARG_DESCRIPTION}"
+            VERBATIM
+    )
+    add_executable(${target} ${generated} ${ARG_SOURCES})
+    target_link_libraries(${target} deception-core)
+endfunction()
@@ -0,0 +1,466 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Benchmarks for the interpreter hot paths. All inputs are generated locally from a fixed seed so runs are
+ * reproducible, and every result is printed as a single line of JSON so they can be collected and compared between
+ * releases.
+ *
+ * usage: deception-bench [--repetitions N] [--scale N] [--filter substring]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <core/BatchRunner.h>
+#include <core/Interpreter.h>
+#include <core/SessionLoop.h>
+#include <core/Codes.h>
+#include <core/Disassembler.h>
+#include <core/Json.h>
+
+namespace {
+    using Deception::Interpreter;
+    using Deception::jsonEscape;
+    using CustomTable = Interpreter::Conclave::CustomInputEntry;
+    template<char Code, auto Action>
+    using Entry = Deception::StaticEntry<Code, Action>;
+    namespace Tables {
+        enum : Deception::TableHandle {
+            SingleLineComment,
+            ReadString,
+            Nested,
+            Core,
+        };
+    } // end namespace Tables
+    // mirrors the core table of the simple interpreter minus anything that prints
+    using CoreTable = Interpreter::StaticTable<
+            Entry<Deception::Opcodes::Ascii::EOT, [](Interpreter& interpreter, char) { interpreter.terminate(); }>,
+            Entry<'#', [](Interpreter& interpreter, char) { interpreter.use(Tables::SingleLineComment); }>,
+            Entry<Deception::Opcodes::TopLevelCodes::StartMakeString, [](Interpreter& interpreter, char) { interpreter.use(Tables::ReadString); }>,
+            Entry<'[', [](Interpreter& interpreter, char) { interpreter.use(Tables::Nested); }>,
+            Entry<'{', [](Interpreter& interpreter, char) { interpreter.use("nested"); }>,
+            Entry<'d', [](Interpreter& interpreter, char) { interpreter.getDataStack().clear(); }>
+    >;
+    using NestedTable = Interpreter::StaticTable<
+            Entry<']', [](Interpreter& interpreter, char) { interpreter.restore(); }>,
+            Entry<'}', [](Interpreter& interpreter, char) { interpreter.restore(); }>
+    >;
+    Interpreter::SharedConclave
+    makeTables() {
+        return Interpreter::snapshot({
+                CustomTable { "single line comment", std::make_shared<Deception::DropCharactersUntil<Interpreter>>('\n') },
+                CustomTable { "read string", std::make_shared<Deception::StringConstructionTable<Interpreter>>(Deception::Opcodes::TopLevelCodes::EndMakeString) },
+                CustomTable { "nested", std::make_shared<NestedTable>() },
+                CustomTable { "core", std::make_shared<CoreTable>() },
+        });
+    }
+    Interpreter
+    makeInterpreter() {
+        Interpreter result { makeTables(), { } };
+        result.setTraceMode(Deception::TraceMode::Off);
+        result.use(Tables::Core);
+        return result;
+    }
+    struct Options {
+        int repetitions = 5;
+        std::size_t scale = 1;
+        std::string filter;
+    };
+    struct Measurement {
+        double seconds;
+        std::size_t bytes;
+        std::size_t operations;
+    };
+    using Benchmark = std::function<Measurement()>;
+
+    /**
+     * Run a benchmark several times and report the median so a single noisy run does not skew the result
+     * @param workers The number of threads the benchmark runs on, it is reported separately so that the name stays
+     * the same from one machine to the next
+     */
+    void
+    report(const std::string& name, const Options& options, const Benchmark& benchmark, std::size_t workers = 1) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+            return;
+        }
+        std::vector<Measurement> runs;
+        for (int i = 0; i < options.repetitions; ++i) {
+            runs.push_back(benchmark());
+        }
+        std::sort(runs.begin(), runs.end(), [](const Measurement& a, const Measurement& b) { return a.seconds < b.seconds; });
+        const auto& median = runs[runs.size() / 2];
+        std::cout << "{\"name\": \"" << jsonEscape(name) << "\""
+                  << ", \"workers\": " << workers
+                  << ", \"repetitions\": " << runs.size()
+                  << ", \"seconds\": " << median.seconds
+                  << ", \"min_seconds\": " << runs.front().seconds
+                  << ", \"max_seconds\": " << runs.back().seconds
+                  << ", \"bytes\": " << median.bytes
+                  << ", \"operations\": " << median.operations
+                  << ", \"bytes_per_second\": " << (median.seconds > 0 ? static_cast<double>(median.bytes) / median.seconds : 0.0)
+                  << ", \"operations_per_second\": " << (median.seconds > 0 ? static_cast<double>(median.operations) / median.seconds : 0.0)
+                  << "}" << std::endl;
+    }
+    template<typename F>
+    double
+    timeIt(F&& body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    /**
+     * Run the given script through a fresh interpreter, only the run itself is timed
+     */
+    Measurement
+    runScript(const std::string& script, std::size_t operations, const Deception::PairProfile* fused = nullptr) {
+        auto interpreter = makeInterpreter();
+        if (fused) {
+            interpreter.fuse(*fused);
+        }
+        interpreter.useInputStream(std::make_shared<std::stringstream>(script));
+        auto seconds = timeIt([&interpreter]() { interpreter.run(); });
+        return { seconds, script.size(), operations };
+    }
+    std::string
+    randomText(std::mt19937& engine, std::size_t length) {
+        // lower case letters and spaces never have an entry in the core table so they exercise the fallback path
+        static constexpr std::string_view alphabet = "abcefghijklmnopqrstuvwxyz ";
+        std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+        std::string result(length, ' ');
+        for (auto& c : result) {
+            c = alphabet[pick(engine)];
+        }
+        return result;
+    }
+}
+
+int
+main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg { argv[i] };
+        if (arg == "--repetitions" && i + 1 < argc) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--scale" && i + 1 < argc) {
+            options.scale = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--repetitions N] [--scale N] [--filter substring]" << std::endl;
+            return 1;
+        }
+    }
+#ifndef DECEPTION_BUILD_TYPE
+#define DECEPTION_BUILD_TYPE ""
+#endif
+    std::cout << "{\"context\": {\"build_type\": \"" << jsonEscape(DECEPTION_BUILD_TYPE) << "\""
+              << ", \"compiler\": \"" << jsonEscape(__VERSION__) << "\""
+              << ", \"repetitions\": " << options.repetitions
+              << ", \"scale\": " << options.scale << "}}" << std::endl;
+    std::mt19937 engine { 0xDEC0DE };
+    const auto megabytes = 8 * options.scale;
+    {
+        auto script = randomText(engine, megabytes * 1024 * 1024);
+        report("core_table_bytes", options, [&script]() { return runScript(script, script.size()); });
+    }
+    {
+        std::string script;
+        std::size_t count = 0;
+        while (script.size() < megabytes * 1024 * 1024) {
+            script += Deception::Opcodes::TopLevelCodes::StartMakeString;
+            script += randomText(engine, 64);
+            script += Deception::Opcodes::TopLevelCodes::EndMakeString;
+            if (++count % 256 == 0) {
+                script += 'd';
+            }
+        }
+        report("string_construction", options, [&script, count]() { return runScript(script, count); });
+    }
+    {
+        std::string script;
+        std::size_t count = 0;
+        while (script.size() < megabytes * 1024 * 1024) {
+            script += '#';
+            script += randomText(engine, 200);
+            script += '\n';
+            ++count;
+        }
+        report("comment_skipping", options, [&script, count]() { return runScript(script, count); });
+    }
+    {
+        std::string byHandle;
+        std::string byName;
+        auto pairs = megabytes * 1024 * 1024 / 2;
+        for (std::size_t i = 0; i < pairs; ++i) {
+            byHandle += "[]";
+            byName += "{}";
+        }
+        report("table_switch_handle", options, [&byHandle, pairs]() { return runScript(byHandle, pairs); });
+        report("table_switch_name", options, [&byName, pairs]() { return runScript(byName, pairs); });
+        // the pairs are picked from a short warm up run, the same way a saved profile would be collected
+        Deception::PairProfile profile;
+        {
+            auto warmUp = makeInterpreter();
+            warmUp.profilePairs(true);
+            warmUp.useInputStream(std::make_shared<std::stringstream>(byHandle.substr(0, 64 * 1024)));
+            warmUp.run();
+            profile = warmUp.getPairProfile();
+        }
+        report("table_switch_handle_fused", options, [&byHandle, pairs, &profile]() { return runScript(byHandle, pairs, &profile); });
+    }
+    {
+        // the same short piece of code run over and over, once pushed as input each time and once as a routine. Every
+        // character has an action so none of it is skipped over as a span.
+        std::string code;
+        while (code.size() < 256) {
+            code += "[]{}[]{}[]{}[]d";
+        }
+        const std::size_t operations = 64 * 1024 * options.scale;
+        report("repeated_code_as_input", options, [&code, operations]() {
+            auto interpreter = makeInterpreter();
+            auto seconds = timeIt([&interpreter, &code, operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    interpreter.feed(code);
+                    (void)interpreter.runAvailable();
+                }
+            });
+            return Measurement { seconds, code.size() * operations, operations };
+        });
+        report("repeated_code_as_routine", options, [&code, operations]() {
+            auto interpreter = makeInterpreter();
+            Interpreter::Routine routine { code };
+            auto seconds = timeIt([&interpreter, &routine, operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    interpreter.execute(routine);
+                }
+            });
+            return Measurement { seconds, code.size() * operations, operations };
+        });
+    }
+    {
+        const std::size_t operations = 4 * 1024 * 1024 * options.scale;
+        report("data_stack_push_pop", options, [operations]() {
+            auto interpreter = makeInterpreter();
+            auto seconds = timeIt([&interpreter, operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    interpreter.pushElement(static_cast<Deception::Integer>(i));
+                    if ((i & 0xFF) == 0xFF) {
+                        while (!interpreter.dataStackEmpty()) {
+                            (void)interpreter.popElement();
+                        }
+                    }
+                }
+            });
+            return Measurement { seconds, 0, operations * 2 };
+        });
+    }
+    {
+        const std::size_t operations = 256 * options.scale;
+        report("memory_space_construction_256M", options, [operations]() {
+            auto seconds = timeIt([operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    Deception::MemorySpace space { 256 * 1024 * 1024 };
+                    space[static_cast<Deception::Address>(i)] = 1;
+                }
+            });
+            return Measurement { seconds, 0, operations };
+        });
+        report("memory_space_construction_4G", options, [operations]() {
+            auto seconds = timeIt([operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    Deception::MemorySpace space { 0 };
+                    space[static_cast<Deception::Address>(i)] = 1;
+                }
+            });
+            return Measurement { seconds, 0, operations };
+        });
+    }
+    {
+        // many small independent scripts, once on a single worker and once on every hardware thread
+        std::vector<Deception::BatchJob> jobs;
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < 512 * options.scale; ++i) {
+            std::string script;
+            while (script.size() < 64 * 1024) {
+                script += Deception::Opcodes::TopLevelCodes::StartMakeString;
+                script += randomText(engine, 64);
+                script += Deception::Opcodes::TopLevelCodes::EndMakeString;
+                script += 'd';
+            }
+            bytes += script.size();
+            jobs.push_back(Deception::BatchJob::code(std::to_string(i), std::move(script)));
+        }
+        auto tables = makeTables();
+        for (std::size_t workers : { std::size_t { 1 }, std::size_t { 0 } }) {
+            Deception::BatchRunner runner { tables, { .workers = workers, .entry = Tables::Core, .prelude = { } } };
+            report(workers == 1 ? "batch_runner_single_worker" : "batch_runner_all_workers", options, [&runner, &jobs, bytes]() {
+                auto seconds = timeIt([&runner, &jobs]() { (void)runner.run(jobs); });
+                return Measurement { seconds, bytes, jobs.size() };
+            }, runner.workers());
+        }
+        // every job starts with the same setup code, which each worker compiles once and runs as a routine
+        std::string prelude;
+        while (prelude.size() < 4 * 1024) {
+            prelude += "[]#";
+            prelude += randomText(engine, 60);
+            prelude += '\n';
+        }
+        Deception::BatchRunner withPrelude { tables, { .entry = Tables::Core, .prelude = prelude } };
+        report("batch_runner_prelude", options, [&withPrelude, &jobs, bytes, &prelude]() {
+            auto seconds = timeIt([&withPrelude, &jobs]() { (void)withPrelude.run(jobs); });
+            return Measurement { seconds, bytes + prelude.size() * jobs.size(), jobs.size() };
+        }, withPrelude.workers());
+    }
+    {
+        // bulk operations over a region the size of a large ROM image
+        const std::size_t length = megabytes * 1024 * 1024;
+        Deception::MemorySpace space { static_cast<Deception::Address>(2 * length) };
+        std::uniform_int_distribution<int> pick(0, 0xFE);
+        for (std::size_t i = 0; i < length; ++i) {
+            space[static_cast<Deception::Address>(i)] = static_cast<char>(pick(engine));
+        }
+        report("memory_fill", options, [&space, length]() {
+            auto seconds = timeIt([&space, length]() { space.fill(length, length, 0x5A); });
+            return Measurement { seconds, length, 1 };
+        });
+        report("memory_move", options, [&space, length]() {
+            auto seconds = timeIt([&space, length]() { space.move(length, 0, length); });
+            return Measurement { seconds, length, 1 };
+        });
+        report("memory_compare", options, [&space, length]() {
+            auto seconds = timeIt([&space, length]() { (void)space.compare(0, length, length); });
+            return Measurement { seconds, length, 1 };
+        });
+        report("memory_find_byte", options, [&space, length]() {
+            // 0xFF never shows up so the whole region is scanned
+            auto seconds = timeIt([&space, length]() { (void)space.find(0, length, static_cast<char>(0xFF)); });
+            return Measurement { seconds, length, 1 };
+        });
+        report("memory_sum32", options, [&space, length]() {
+            auto seconds = timeIt([&space, length]() { (void)space.sum32(0, length); });
+            return Measurement { seconds, length, 1 };
+        });
+        report("memory_crc32", options, [&space, length]() {
+            auto seconds = timeIt([&space, length]() { (void)space.crc32(0, length); });
+            return Measurement { seconds, length, 1 };
+        });
+    }
+    {
+        // every code shows up so all of the name tables are exercised, the output is thrown away
+        std::string trace(megabytes * 1024 * 1024, '\0');
+        std::uniform_int_distribution<int> pick(0, 0xFF);
+        for (auto& c : trace) {
+            c = static_cast<char>(pick(engine));
+        }
+        report("trace_disassembly", options, [&trace]() {
+            std::ofstream sink { "/dev/null" };
+            auto seconds = timeIt([&trace, &sink]() {
+                Deception::TraceDisassembler disassembler { sink };
+                disassembler.write(trace);
+            });
+            return Measurement { seconds, trace.size(), trace.size() };
+        });
+    }
+    {
+        // a 256M interpreter with 16M in use, the checkpoint pays for what is in use and each fork should not
+        const std::size_t operations = 256 * options.scale;
+        auto interpreter = std::make_unique<Interpreter>(makeTables(), std::initializer_list<Deception::InputStream> { }, 256 * 1024 * 1024);
+        for (Deception::Address i = 0; i < 16 * 1024 * 1024; i += 4096) {
+            interpreter->getMemory()[i] = 1;
+        }
+        report("checkpoint_16M_of_256M", options, [&interpreter]() {
+            auto seconds = timeIt([&interpreter]() { (void)interpreter->checkpoint(); });
+            return Measurement { seconds, 16 * 1024 * 1024, 1 };
+        });
+        auto checkpoint = interpreter->checkpoint();
+        report("fork_256M", options, [&checkpoint, operations]() {
+            auto seconds = timeIt([&checkpoint, operations]() {
+                for (std::size_t i = 0; i < operations; ++i) {
+                    auto branch = checkpoint->fork();
+                    branch.getMemory()[static_cast<Deception::Address>(i)] = 1;
+                }
+            });
+            return Measurement { seconds, 0, operations };
+        });
+        // a branch only pays for the pages it changed and the data its parent snapshot holds, not for its capacity
+        auto branch = checkpoint->fork();
+        for (Deception::Address i = 0; i < 1024 * 1024; i += 4096) {
+            branch.getMemory()[i] = 2;
+        }
+        report("checkpoint_of_fork_256M", options, [&branch]() {
+            auto seconds = timeIt([&branch]() { (void)branch.checkpoint(); });
+            return Measurement { seconds, 16 * 1024 * 1024, 1 };
+        });
+    }
+#ifdef __linux__
+    {
+        // one thread feeding many interpreters through pipes, each pipe gets its whole script before the loop starts
+        const std::size_t sessions = 256;
+        std::string script;
+        std::size_t count = 0;
+        while (script.size() < 48 * 1024) {
+            script += Deception::Opcodes::TopLevelCodes::StartMakeString;
+            script += randomText(engine, 64);
+            script += Deception::Opcodes::TopLevelCodes::EndMakeString;
+            script += 'd';
+            ++count;
+        }
+        auto tables = makeTables();
+        report("session_loop_pipes", options, [&tables, &script, count, sessions]() {
+            Deception::SessionLoop loop;
+            for (std::size_t i = 0; i < sessions; ++i) {
+                int ends[2];
+                if (::pipe(ends) != 0) {
+                    std::cerr << "unable to create pipe" << std::endl;
+                    std::exit(1);
+                }
+                auto interpreter = std::make_unique<Interpreter>(tables, std::initializer_list<Deception::InputStream> { });
+                interpreter->setTraceMode(Deception::TraceMode::Off);
+                interpreter->use(Tables::Core);
+                loop.add(ends[0], std::move(interpreter));
+                // a pipe holds 64k by default so this never blocks
+                if (::write(ends[1], script.data(), script.size()) != static_cast<ssize_t>(script.size())) {
+                    std::cerr << "short write to pipe" << std::endl;
+                    std::exit(1);
+                }
+                ::close(ends[1]);
+            }
+            auto seconds = timeIt([&loop]() { loop.run(); });
+            return Measurement { seconds, script.size() * sessions, count * sessions };
+        });
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,643 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Turns a conclave description into a C++ interpreter which dispatches with a switch per table. The description is
+ * line based, blank lines and lines starting with # are ignored:
+ *
+ *   include <header>              include a header in the generated source, for functions named by call
+ *   entry <table>                 the table the interpreter starts in
+ *   table <name>                  start describing a table, everything up to the matching end belongs to it
+ *       on <char>... <actions>    the actions run when one of the given characters is dispatched
+ *       default <actions>         the actions run for characters without an entry
+ *       enter <actions>           the actions run when the table is used
+ *       leave <actions>           the actions run when the table is restored or uses another table
+ *       span append|skip until <char>...
+ *                                 everything up to one of the given characters is appended to the string being
+ *                                 built or skipped in one go, the characters themselves are dispatched as usual
+ *   end
+ *
+ * A character is a quoted literal ('a', '\n', '\x98'), a number (0x98, 152) or a name from AsciiCodes.def
+ * (StartMakeString, Ascii::EOT). The actions are:
+ *
+ *   use <table>       switch to a table
+ *   restore           go back to the previous table
+ *   terminate         stop the interpreter
+ *   append            append the character to the string being built
+ *   clear             clear the string being built
+ *   emit              push the string being built onto the data stack
+ *   push              push the character onto the data stack
+ *   call <function>   call void function(Deception::Compiled::State&, char), unqualified names are declared for you
+ *   ignore            do nothing
+ *
+ * usage: deception-codegen [--namespace name] [--no-main] [-o output] description
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <core/Codes.h>
+
+namespace {
+    struct Action {
+        enum class Kind {
+            Use,
+            Restore,
+            Terminate,
+            Append,
+            Clear,
+            Emit,
+            Push,
+            Call,
+            Ignore,
+        };
+        Kind kind;
+        std::string argument;
+        /**
+         * @return true if the action can change the current table or stop the interpreter
+         */
+        [[nodiscard]] bool switches() const noexcept { return kind == Kind::Use || kind == Kind::Restore || kind == Kind::Terminate || kind == Kind::Call; }
+    };
+    using Actions = std::vector<Action>;
+    struct TableDescription {
+        enum class Span {
+            None,
+            Append,
+            Skip,
+        };
+        std::string name;
+        std::size_t line = 0;
+        Actions enter;
+        Actions leave;
+        std::optional<Actions> fallback;
+        Span span = Span::None;
+        std::string terminators;
+        std::map<unsigned char, Actions> entries;
+    };
+    struct Description {
+        std::string path;
+        std::string entry;
+        std::size_t entryLine = 0;
+        std::vector<std::string> includes;
+        std::vector<TableDescription> tables;
+        [[nodiscard]] const TableDescription* find(std::string_view name) const noexcept {
+            auto result = std::find_if(tables.begin(), tables.end(), [name](const auto& table) { return table.name == name; });
+            return result == tables.end() ? nullptr : &*result;
+        }
+    };
+    struct ParseError {
+        std::size_t line;
+        std::string message;
+    };
+    /**
+     * Split a line into words, quoted characters are kept together so ' ' is a single word
+     */
+    std::vector<std::string>
+    tokenize(std::string_view line, std::size_t number) {
+        std::vector<std::string> result;
+        std::size_t i = 0;
+        while (i < line.size()) {
+            if (std::isspace(static_cast<unsigned char>(line[i]))) {
+                ++i;
+                continue;
+            }
+            auto start = i;
+            if (line[i] == '\'') {
+                for (++i; i < line.size() && line[i] != '\''; ++i) {
+                    if (line[i] == '\\') {
+                        ++i;
+                    }
+                }
+                if (i >= line.size()) {
+                    throw ParseError { number, "unterminated character literal" };
+                }
+                ++i;
+            } else {
+                while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+                    ++i;
+                }
+            }
+            result.emplace_back(line.substr(start, i - start));
+        }
+        return result;
+    }
+    std::optional<unsigned int>
+    parseNumber(std::string_view text, int base) {
+        unsigned int value = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        if (error != std::errc{} || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+    char
+    parseCharacter(const std::string& word, std::size_t line) {
+        std::optional<unsigned int> value;
+        if (word.size() >= 3 && word.front() == '\'' && word.back() == '\'') {
+            std::string_view body { word.data() + 1, word.size() - 2 };
+            if (body.size() == 1 && body[0] != '\\') {
+                value = static_cast<unsigned char>(body[0]);
+            } else if (body.size() == 2 && body[0] == '\\') {
+                switch (body[1]) {
+                    case 'n': value = '\n'; break;
+                    case 't': value = '\t'; break;
+                    case 'r': value = '\r'; break;
+                    case '0': value = 0; break;
+                    case '\\': value = '\\'; break;
+                    case '\'': value = '\''; break;
+                    default: break;
+                }
+            } else if (body.size() > 2 && body.substr(0, 2) == "\\x") {
+                value = parseNumber(body.substr(2), 16);
+            }
+        } else if (word.size() > 2 && (word.starts_with("0x") || word.starts_with("0X"))) {
+            value = parseNumber(std::string_view{word}.substr(2), 16);
+        } else if (!word.empty() && std::isdigit(static_cast<unsigned char>(word.front()))) {
+            value = parseNumber(word, 10);
+        } else if (auto code = Deception::Opcodes::encode(word); code) {
+            value = static_cast<unsigned char>(*code);
+        }
+        if (!value || *value > 0xFF) {
+            throw ParseError { line, "not a character: " + word };
+        }
+        return static_cast<char>(*value);
+    }
+    bool
+    isCharacter(const std::string& word) {
+        if (word.front() == '\'' || std::isdigit(static_cast<unsigned char>(word.front()))) {
+            return true;
+        }
+        return Deception::Opcodes::encode(word).has_value();
+    }
+    Actions
+    parseActions(const std::vector<std::string>& words, std::size_t first, std::size_t line) {
+        static const std::map<std::string_view, Action::Kind> keywords {
+                { "use", Action::Kind::Use },
+                { "restore", Action::Kind::Restore },
+                { "terminate", Action::Kind::Terminate },
+                { "append", Action::Kind::Append },
+                { "clear", Action::Kind::Clear },
+                { "emit", Action::Kind::Emit },
+                { "push", Action::Kind::Push },
+                { "call", Action::Kind::Call },
+                { "ignore", Action::Kind::Ignore },
+        };
+        Actions result;
+        for (auto i = first; i < words.size(); ++i) {
+            auto kind = keywords.find(words[i]);
+            if (kind == keywords.end()) {
+                throw ParseError { line, "unknown action: " + words[i] };
+            }
+            Action action { kind->second, { } };
+            if (action.kind == Action::Kind::Use || action.kind == Action::Kind::Call) {
+                if (++i == words.size()) {
+                    throw ParseError { line, words[i - 1] + " needs an argument" };
+                }
+                action.argument = words[i];
+            }
+            result.push_back(std::move(action));
+        }
+        if (result.empty()) {
+            throw ParseError { line, "expected at least one action" };
+        }
+        return result;
+    }
+    void
+    parseClause(TableDescription& table, const std::vector<std::string>& words, std::size_t line) {
+        const auto& keyword = words.front();
+        if (keyword == "on") {
+            std::size_t i = 1;
+            std::vector<char> characters;
+            for (; i < words.size() && isCharacter(words[i]); ++i) {
+                characters.push_back(parseCharacter(words[i], line));
+            }
+            if (characters.empty()) {
+                if (words.size() > 1) {
+                    // report why the first word is not a character
+                    parseCharacter(words[1], line);
+                }
+                throw ParseError { line, "on needs at least one character" };
+            }
+            auto actions = parseActions(words, i, line);
+            for (auto c : characters) {
+                if (!table.entries.emplace(static_cast<unsigned char>(c), actions).second) {
+                    throw ParseError { line, "character given more than once in table " + table.name };
+                }
+            }
+        } else if (keyword == "default") {
+            table.fallback = parseActions(words, 1, line);
+        } else if (keyword == "enter" || keyword == "leave") {
+            auto actions = parseActions(words, 1, line);
+            // there is no character to work with when entering or leaving
+            for (const auto& action : actions) {
+                if (action.kind == Action::Kind::Append || action.kind == Action::Kind::Push) {
+                    throw ParseError { line, keyword + " actions cannot use the current character" };
+                }
+            }
+            (keyword == "enter" ? table.enter : table.leave) = std::move(actions);
+        } else if (keyword == "span") {
+            if (words.size() < 4 || (words[1] != "append" && words[1] != "skip") || words[2] != "until") {
+                throw ParseError { line, "expected span append|skip until <char>..." };
+            }
+            table.span = words[1] == "append" ? TableDescription::Span::Append : TableDescription::Span::Skip;
+            table.terminators.clear();
+            for (std::size_t i = 3; i < words.size(); ++i) {
+                table.terminators.push_back(parseCharacter(words[i], line));
+            }
+        } else {
+            throw ParseError { line, "unknown clause: " + keyword };
+        }
+    }
+    std::string
+    identifier(std::string_view name) {
+        static const std::set<std::string_view> reserved {
+                "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "class", "const",
+                "constexpr", "continue", "default", "delete", "do", "double", "else", "enum", "explicit", "export",
+                "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+                "namespace", "new", "not", "nullptr", "operator", "or", "private", "protected", "public", "register",
+                "return", "short", "signed", "sizeof", "static", "struct", "switch", "template", "this", "throw", "true",
+                "try", "typedef", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "while",
+        };
+        std::string result;
+        for (auto c : name) {
+            result.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+        }
+        if (result.empty() || std::isdigit(static_cast<unsigned char>(result.front())) || reserved.contains(result)) {
+            result.insert(result.begin(), '_');
+        }
+        return result;
+    }
+    Description
+    parse(std::istream& in, const std::string& path) {
+        Description result;
+        result.path = path;
+        TableDescription* current = nullptr;
+        std::string text;
+        std::size_t line = 0;
+        while (std::getline(in, text)) {
+            ++line;
+            auto words = tokenize(text, line);
+            if (words.empty() || words.front().starts_with('#')) {
+                continue;
+            }
+            const auto& keyword = words.front();
+            if (current) {
+                if (keyword == "end") {
+                    current = nullptr;
+                } else {
+                    parseClause(*current, words, line);
+                }
+            } else if (keyword == "table" && words.size() == 2) {
+                if (result.find(words[1])) {
+                    throw ParseError { line, "table described more than once: " + words[1] };
+                }
+                current = &result.tables.emplace_back();
+                current->name = words[1];
+                current->line = line;
+            } else if (keyword == "entry" && words.size() == 2) {
+                result.entry = words[1];
+                result.entryLine = line;
+            } else if (keyword == "include" && words.size() == 2) {
+                result.includes.push_back(words[1]);
+            } else {
+                throw ParseError { line, "expected table, entry or include" };
+            }
+        }
+        if (current) {
+            throw ParseError { current->line, "table " + current->name + " is missing its end" };
+        }
+        if (result.tables.empty()) {
+            throw ParseError { line, "no tables described" };
+        }
+        if (result.entry.empty()) {
+            throw ParseError { line, "no entry table given" };
+        }
+        if (!result.find(result.entry)) {
+            throw ParseError { result.entryLine, "unknown table: " + result.entry };
+        }
+        // names which only differ in punctuation map onto the same enumerator, which would not compile
+        std::map<std::string, const TableDescription*> identifiers;
+        for (const auto& table : result.tables) {
+            if (auto [existing, added] = identifiers.emplace(identifier(table.name), &table); !added) {
+                throw ParseError { table.line, "table " + table.name + " has the same generated name as table " + existing->second->name + " (" + existing->first + ")" };
+            }
+        }
+        // every table transition is resolved now so the generated code never looks a table up by name
+        for (const auto& table : result.tables) {
+            auto check = [&result, &table](const Actions& actions) {
+                for (const auto& action : actions) {
+                    if (action.kind == Action::Kind::Use && !result.find(action.argument)) {
+                        throw ParseError { table.line, "table " + table.name + " uses unknown table " + action.argument };
+                    }
+                }
+            };
+            check(table.enter);
+            check(table.leave);
+            if (table.fallback) {
+                check(*table.fallback);
+            }
+            for (const auto& [c, actions] : table.entries) {
+                check(actions);
+            }
+        }
+        return result;
+    }
+    std::string
+    characterLiteral(char c) {
+        static constexpr char digits[] = "0123456789abcdef";
+        auto value = static_cast<unsigned char>(c);
+        return std::string { "static_cast<char>(0x" } + digits[value >> 4] + digits[value & 0xF] + ")";
+    }
+    /**
+     * Writes the generated source, the layout mirrors what would be written by hand
+     */
+    class Generator {
+    public:
+        Generator(const Description& description, std::ostream& out, std::string space) : _description(description), _out(out), _namespace(std::move(space)) { }
+        void generate(bool withMain) {
+            _out << "// generated by deception-codegen from " << _description.path << ", do not edit\n"
+                 << "#include <core/Compiled.h>\n";
+            for (const auto& header : _description.includes) {
+                _out << "#include " << header << "\n";
+            }
+            declareFunctions();
+            _out << "namespace " << _namespace << " {\n"
+                 << "    using State = Deception::Compiled::State;\n"
+                 << "    enum class Table : State::TableId {\n";
+            for (const auto& table : _description.tables) {
+                _out << "        " << identifier(table.name) << ",\n";
+            }
+            _out << "    };\n";
+            generateTransitions();
+            generateDispatch();
+            _out << "    /**\n"
+                 << "     * Use the entry table, call this once before dispatching anything\n"
+                 << "     */\n"
+                 << "    void\n"
+                 << "    start(State& state) {\n"
+                 << "        use(state, Table::" << identifier(_description.entry) << ");\n"
+                 << "    }\n"
+                 << "} // end namespace " << _namespace << "\n";
+            if (withMain) {
+                _out << "\n"
+                     << "int\n"
+                     << "main(int argc, char** argv) {\n"
+                     << "    Deception::Compiled::State state;\n"
+                     << "    " << _namespace << "::start(state);\n"
+                     << "    state.out() << \"CTRL-D to quit\\n\";\n"
+                     << "    return Deception::Compiled::runMain(state, argc, argv, " << _namespace << "::dispatch);\n"
+                     << "}\n";
+            }
+        }
+    private:
+        void declareFunctions() {
+            std::set<std::string> functions;
+            auto collect = [&functions](const Actions& actions) {
+                for (const auto& action : actions) {
+                    if (action.kind == Action::Kind::Call && action.argument.find("::") == std::string::npos) {
+                        functions.insert(action.argument);
+                    }
+                }
+            };
+            for (const auto& table : _description.tables) {
+                collect(table.enter);
+                collect(table.leave);
+                if (table.fallback) {
+                    collect(*table.fallback);
+                }
+                for (const auto& [c, actions] : table.entries) {
+                    collect(actions);
+                }
+            }
+            for (const auto& function : functions) {
+                _out << "void " << function << "(Deception::Compiled::State& state, char c);\n";
+            }
+        }
+        void writeActions(const Actions& actions, const std::string& indent, std::string_view character) {
+            for (const auto& action : actions) {
+                switch (action.kind) {
+                    case Action::Kind::Use:
+                        _out << indent << "use(state, Table::" << identifier(action.argument) << ");\n";
+                        break;
+                    case Action::Kind::Restore:
+                        _out << indent << "restore(state);\n";
+                        break;
+                    case Action::Kind::Terminate:
+                        _out << indent << "state.executing = false;\n";
+                        break;
+                    case Action::Kind::Append:
+                        _out << indent << "state.output.push_back(" << character << ");\n";
+                        break;
+                    case Action::Kind::Clear:
+                        _out << indent << "state.output.clear();\n";
+                        break;
+                    case Action::Kind::Emit:
+                        _out << indent << "state.dataStack.push(Deception::Value { state.output });\n";
+                        break;
+                    case Action::Kind::Push:
+                        _out << indent << "state.dataStack.push(Deception::Value { " << character << " });\n";
+                        break;
+                    case Action::Kind::Call:
+                        _out << indent << action.argument << "(state, " << character << ");\n";
+                        break;
+                    case Action::Kind::Ignore:
+                        break;
+                }
+            }
+        }
+        void writeHook(std::string_view name, Actions TableDescription::* hook) {
+            _out << "    inline void\n"
+                 << "    " << name << "(State& state, Table table) {\n"
+                 << "        switch (table) {\n";
+            for (const auto& table : _description.tables) {
+                if (const auto& actions = table.*hook; !actions.empty()) {
+                    _out << "            case Table::" << identifier(table.name) << ":\n";
+                    writeActions(actions, "                ", "'\\0'");
+                    _out << "                break;\n";
+                }
+            }
+            _out << "            default:\n"
+                 << "                break;\n"
+                 << "        }\n"
+                 << "    }\n";
+        }
+        void generateTransitions() {
+            // enter and leave hooks can use and restore tables themselves so everything is declared up front
+            _out << "    inline void use(State& state, Table table);\n"
+                 << "    inline void restore(State& state);\n";
+            writeHook("enter", &TableDescription::enter);
+            writeHook("leave", &TableDescription::leave);
+            _out << "    inline void\n"
+                 << "    use(State& state, Table table) {\n"
+                 << "        // the table being switched away from is left first, the same as Interpreter::use\n"
+                 << "        if (!state.tables.empty()) {\n"
+                 << "            leave(state, static_cast<Table>(state.tables.back()));\n"
+                 << "        }\n"
+                 << "        state.tables.push_back(static_cast<State::TableId>(table));\n"
+                 << "        enter(state, table);\n"
+                 << "    }\n"
+                 << "    inline void\n"
+                 << "    restore(State& state) {\n"
+                 << "        if (!state.tables.empty()) {\n"
+                 << "            leave(state, static_cast<Table>(state.tables.back()));\n"
+                 << "            state.tables.pop_back();\n"
+                 << "        }\n"
+                 << "    }\n";
+        }
+        void writeCase(const Actions& actions) {
+            writeActions(actions, "                                ", "c");
+            // anything that may leave the table goes back to the outer switch, everything else stays in this loop
+            if (std::any_of(actions.begin(), actions.end(), [](const auto& action) { return action.switches(); })) {
+                _out << "                                goto next;\n";
+            } else {
+                _out << "                                continue;\n";
+            }
+        }
+        void generateDispatch() {
+            _out << "    /**\n"
+                 << "     * Dispatch every character in [position, end), this only returns early once the interpreter has terminated\n"
+                 << "     */\n"
+                 << "    const char*\n"
+                 << "    dispatch(State& state, const char* position, const char* end) {\n"
+                 << "        while (position != end && state.executing && !state.tables.empty()) {\n"
+                 << "            switch (static_cast<Table>(state.tables.back())) {\n";
+            for (const auto& table : _description.tables) {
+                _out << "                case Table::" << identifier(table.name) << ":\n"
+                     << "                    while (position != end) {\n";
+                if (table.span != TableDescription::Span::None) {
+                    _out << "                        {\n"
+                         << "                            auto stop = Deception::findFirstOf(position, end, std::string_view { \"";
+                    for (auto c : table.terminators) {
+                        static constexpr char digits[] = "0123456789abcdef";
+                        auto value = static_cast<unsigned char>(c);
+                        _out << "\\x" << digits[value >> 4] << digits[value & 0xF];
+                    }
+                    _out << "\", " << table.terminators.size() << " });\n";
+                    if (table.span == TableDescription::Span::Append) {
+                        _out << "                            state.output.append(position, stop);\n";
+                    }
+                    _out << "                            position = stop;\n"
+                         << "                        }\n"
+                         << "                        if (position == end) {\n"
+                         << "                            break;\n"
+                         << "                        }\n";
+                }
+                _out << "                        auto c = *position++;\n"
+                     << "                        switch (c) {\n";
+                for (const auto& [value, actions] : table.entries) {
+                    auto c = static_cast<char>(value);
+                    _out << "                            case " << characterLiteral(c) << ":";
+                    if (auto name = Deception::Opcodes::mnemonic(c); !name.empty() && std::isprint(value) == 0) {
+                        _out << " // " << name;
+                    } else if (std::isprint(value)) {
+                        _out << " // '" << c << "'";
+                    }
+                    _out << "\n";
+                    writeCase(actions);
+                }
+                _out << "                            default:\n";
+                if (table.fallback) {
+                    writeCase(*table.fallback);
+                } else {
+                    _out << "                                continue;\n";
+                }
+                _out << "                        }\n"
+                     << "                    }\n"
+                     << "                    break;\n";
+            }
+            _out << "            }\n"
+                 << "        next:\n"
+                 << "            ;\n"
+                 << "        }\n"
+                 << "        return position;\n"
+                 << "    }\n";
+        }
+    private:
+        const Description& _description;
+        std::ostream& _out;
+        std::string _namespace;
+    };
+}
+
+int
+main(int argc, char** argv) {
+    std::string space { "Generated" };
+    std::string output;
+    std::string input;
+    bool withMain = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg { argv[i] };
+        if (arg == "--namespace" && i + 1 < argc) {
+            space = argv[++i];
+        } else if (arg == "--no-main") {
+            withMain = false;
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (input.empty() && !arg.starts_with('-')) {
+            input = arg;
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "usage: " << argv[0] << " [--namespace name] [--no-main] [-o output] description" << std::endl;
+        return 1;
+    }
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "Unable to open " << input << std::endl;
+        return 1;
+    }
+    Description description;
+    try {
+        description = parse(in, input);
+    } catch (const ParseError& error) {
+        std::cerr << input << ":" << error.line << ": " << error.message << std::endl;
+        return 1;
+    }
+    // the source is generated in memory first so a failed run never leaves a partial file behind
+    std::ostringstream generated;
+    Generator(description, generated, space).generate(withMain);
+    if (output.empty()) {
+        std::cout << generated.str();
+        return 0;
+    }
+    std::ofstream out(output);
+    if (!(out << generated.str()) || !out.flush()) {
+        std::cerr << "Unable to write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
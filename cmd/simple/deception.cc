@@ -23,6 +23,8 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <array>
+#include <charconv>
 #include <iostream>
 #include <core/Interpreter.h>
 #include <core/Codes.h>
@@ -33,9 +35,253 @@ using CustomTable = Deception::Interpreter::Conclave::CustomInputEntry;
 
 template<typename Interpreter>
 using StringConstructionTable = Deception::StringConstructionTable<Interpreter>;
+template<char Code, auto Action>
+using Entry = Deception::StaticEntry<Code, Action>;
+
+// handles are handed out in the order the tables are given to the interpreter in main
+namespace Tables {
+    enum : Deception::TableHandle {
+        SkipNextCharacter,
+        SingleLineComment,
+        MultiLineComment,
+        ReadString,
+        ReadLine,
+        Core,
+        Memory,
+    };
+} // end namespace Tables
+
+// operations on the memory space, reached through 'm' in the core table. Each one takes its arguments off of the data
+// stack in the order they were pushed and then goes back to the previous table. Numbers are either strings (decimal or
+// 0x prefixed hex) or results of earlier operations.
+namespace Memory {
+    std::optional<Deception::Ordinal>
+    toNumber(const Deception::Value& top) {
+        if (top.isOrdinal()) {
+            return top.asOrdinal();
+        } else if (top.isInteger() && top.asInteger() >= 0) {
+            return static_cast<Deception::Ordinal>(top.asInteger());
+        } else if (top.isCharacter()) {
+            return static_cast<unsigned char>(top.asCharacter());
+        } else if (top.isString()) {
+            std::string_view text = top.asString();
+            int base = 10;
+            if (text.starts_with("0x") || text.starts_with("0X")) {
+                text.remove_prefix(2);
+                base = 16;
+            }
+            Deception::Ordinal value = 0;
+            if (auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base); !text.empty() && error == std::errc { } && end == text.data() + text.size()) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+    std::optional<Deception::Ordinal>
+    popNumber(Deception::Interpreter& interpreter) {
+        return toNumber(interpreter.popElement());
+    }
+    /**
+     * Pop the given number of numbers
+     * @return The numbers in the order they were pushed or std::nullopt if any of them was not a number
+     */
+    template<std::size_t Count>
+    std::optional<std::array<Deception::Ordinal, Count>>
+    popNumbers(Deception::Interpreter& interpreter) {
+        std::array<Deception::Ordinal, Count> result { };
+        bool valid = true;
+        for (auto i = Count; i > 0; --i) {
+            if (auto value = popNumber(interpreter); value) {
+                result[i - 1] = *value;
+            } else {
+                valid = false;
+            }
+        }
+        return valid ? std::make_optional(result) : std::nullopt;
+    }
+    void
+    report(const char* operation) {
+        std::cerr << "memory " << operation << ": bad arguments or range out of bounds" << std::endl;
+    }
+    /**
+     * Push the address that was found followed by true, or the end of the searched range followed by false if there
+     * was nothing to find. The flag is what tells the two apart since a match can be at any address, including zero.
+     */
+    void
+    pushFound(Deception::Interpreter& interpreter, std::optional<std::size_t> address, std::size_t end) {
+        interpreter.pushElement(static_cast<Deception::Ordinal>(address.value_or(end)));
+        interpreter.pushElement(address.has_value());
+    }
+    // start length value
+    void
+    fill(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<3>(interpreter); !args || !interpreter.getMemory().fill((*args)[0], (*args)[1], static_cast<char>((*args)[2]))) {
+            report("fill");
+        }
+    }
+    // destination source length
+    void
+    move(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<3>(interpreter); !args || !interpreter.getMemory().move((*args)[0], (*args)[1], (*args)[2])) {
+            report("move");
+        }
+    }
+    // first second length -> integer ordering the two ranges
+    void
+    compare(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<3>(interpreter); args) {
+            if (auto result = interpreter.getMemory().compare((*args)[0], (*args)[1], (*args)[2]); result) {
+                interpreter.pushElement(static_cast<Deception::Integer>(*result < 0 ? -1 : (*result > 0 ? 1 : 0)));
+                return;
+            }
+        }
+        report("compare");
+    }
+    // start length byte -> address found
+    void
+    findByte(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<3>(interpreter); args && interpreter.getMemory().contains((*args)[0], (*args)[1])) {
+            pushFound(interpreter, interpreter.getMemory().find((*args)[0], (*args)[1], static_cast<char>((*args)[2])), (*args)[0] + (*args)[1]);
+        } else {
+            report("find");
+        }
+    }
+    // start length pattern -> address found, the pattern is a string
+    void
+    findPattern(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        auto pattern = interpreter.popElement();
+        if (auto args = popNumbers<2>(interpreter); args && pattern.isString() && interpreter.getMemory().contains((*args)[0], (*args)[1])) {
+            pushFound(interpreter, interpreter.getMemory().find((*args)[0], (*args)[1], pattern.asString()), (*args)[0] + (*args)[1]);
+        } else {
+            report("find pattern");
+        }
+    }
+    template<auto Checksum>
+    void
+    checksum(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<2>(interpreter); args) {
+            if (auto result = (interpreter.getMemory().*Checksum)((*args)[0], (*args)[1]); result) {
+                interpreter.pushElement(static_cast<Deception::Ordinal>(*result));
+                return;
+            }
+        }
+        report("checksum");
+    }
+    /**
+     * Pop a number which may be negative, for storing Integers
+     */
+    std::optional<Deception::Integer>
+    popSignedNumber(Deception::Interpreter& interpreter) {
+        auto top = interpreter.popElement();
+        if (top.isInteger()) {
+            return top.asInteger();
+        } else if (top.isString() && top.asString().starts_with('-')) {
+            Deception::Integer value = 0;
+            std::string_view text = top.asString();
+            if (auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value); error == std::errc { } && end == text.data() + text.size()) {
+                return value;
+            }
+            return std::nullopt;
+        }
+        // everything else is read the same way as an unsigned number, the bits are what get stored
+        if (auto value = toNumber(top); value) {
+            return static_cast<Deception::Integer>(*value);
+        }
+        return std::nullopt;
+    }
+    // address -> value, T is the width in memory and signed types come back as Integers, everything else as Ordinals
+    template<std::integral T, std::endian Order>
+    void
+    load(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        if (auto args = popNumbers<1>(interpreter); args) {
+            if (auto result = interpreter.getMemory().load<T>((*args)[0], Order); result) {
+                if constexpr (std::is_signed_v<T>) {
+                    interpreter.pushElement(static_cast<Deception::Integer>(*result));
+                } else {
+                    interpreter.pushElement(static_cast<Deception::Ordinal>(*result));
+                }
+                return;
+            }
+        }
+        report("load");
+    }
+    // address value, only the low sizeof(T) bytes of value are stored. Signed types also take negative values.
+    template<std::integral T, std::endian Order>
+    void
+    store(Deception::Interpreter& interpreter, char) {
+        interpreter.restore();
+        std::optional<T> value;
+        if constexpr (std::is_signed_v<T>) {
+            if (auto number = popSignedNumber(interpreter); number) {
+                value = static_cast<T>(*number);
+            }
+        } else {
+            if (auto number = popNumber(interpreter); number) {
+                value = static_cast<T>(*number);
+            }
+        }
+        if (auto address = popNumber(interpreter); !value || !address || !interpreter.getMemory().store(*address, *value, Order)) {
+            report("store");
+        }
+    }
+    using Operations = Deception::Interpreter::StaticTable<
+            Entry<'f', fill>,
+            Entry<'m', move>,
+            Entry<'c', compare>,
+            Entry<'b', findByte>,
+            Entry<'p', findPattern>,
+            Entry<'s', checksum<&Deception::MemorySpace::sum32>>,
+            Entry<'k', checksum<&Deception::MemorySpace::crc32>>,
+            // lower case is little endian and upper case big endian
+            Entry<'l', load<Deception::Address, std::endian::little>>,
+            Entry<'L', load<Deception::Address, std::endian::big>>,
+            Entry<'w', store<Deception::Address, std::endian::little>>,
+            Entry<'W', store<Deception::Address, std::endian::big>>,
+            Entry<'i', load<Deception::Integer, std::endian::little>>,
+            Entry<'I', load<Deception::Integer, std::endian::big>>,
+            Entry<'j', store<Deception::Integer, std::endian::little>>,
+            Entry<'J', store<Deception::Integer, std::endian::big>>,
+            Entry<'o', load<Deception::Ordinal, std::endian::little>>,
+            Entry<'O', load<Deception::Ordinal, std::endian::big>>,
+            Entry<'u', store<Deception::Ordinal, std::endian::little>>,
+            Entry<'U', store<Deception::Ordinal, std::endian::big>>
+    >;
+    struct Table : Operations {
+        void
+        defaultImplementation(Deception::Interpreter& interpreter, char c) override {
+            interpreter.restore();
+            std::cerr << "memory: unknown operation " << Deception::Opcodes::mnemonic(c) << std::endl;
+        }
+    };
+} // end namespace Memory
+
+// the core table never changes at runtime so it is specialized at compile time
+using CoreTable = Deception::Interpreter::StaticTable<
+        Entry<Deception::Opcodes::Ascii::EOT, [](Deception::Interpreter& interpreter, char) { interpreter.terminate(); }>,
+        Entry<'q', [](Deception::Interpreter& interpreter, char) { interpreter.useInputStream(Deception::Opcodes::Ascii::EOT); }>,
+        Entry<'#', [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::SingleLineComment); }>,
+        Entry<'!', [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::ReadLine); }>,
+        Entry<Deception::Opcodes::TopLevelCodes::StartMakeString, [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::ReadString); }>,
+        Entry<Deception::Opcodes::TopLevelCodes::SkipNextCharacter, [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::SkipNextCharacter); }>,
+        Entry<Deception::Opcodes::TopLevelCodes::SwitchToTableFromStack, [](Deception::Interpreter& interpreter, char) { interpreter.useFromStack(); }>,
+        Entry<'.', Deception::displayTopItemOnDataStack>,
+        Entry<'?', Deception::displayCurrentTableContents>,
+        Entry<'%', Deception::displayCounters>,
+        Entry<'m', [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::Memory); }>,
+        Entry<'(', [](Deception::Interpreter& interpreter, char) { interpreter.use(Tables::MultiLineComment); }>
+>;
 
 int
 main(int argc, char** argv) {
+    // let std::cin keep its own buffer so the interpreter can pull input out of it in blocks
+    std::ios_base::sync_with_stdio(false);
     Deception::Interpreter theInterpreter{
             {
                     GenericTable { "skip next character", {{}, [](auto&&) {}, [](auto&&) {}, [](auto& interpreter, char) { interpreter.restore(); } }},
@@ -43,24 +289,19 @@ main(int argc, char** argv) {
                     CustomTable { "multi line comment", std::make_shared<Deception::DropCharactersUntil<Deception::Interpreter>>(')')},
                     CustomTable { "read string", std::make_shared<StringConstructionTable<Deception::Interpreter>>(Deception::Opcodes::TopLevelCodes::EndMakeString) },
                     CustomTable { "read line", std::make_shared<StringConstructionTable<Deception::Interpreter>>('\n') },
-                    GenericTable {
-                            "core", {
-                                    { Deception::Opcodes::Ascii::EOT, [](auto& interpreter, char) { interpreter.terminate(); } },
-                                    { 'q', [](auto& interpreter, char) { interpreter.useInputStream(Deception::Opcodes::Ascii::EOT); } },
-                                    { '#', [](Deception::Interpreter& interpreter, char) {interpreter.use("single line comment"); } },
-                                    { '!', [](auto& interpreter, char) { interpreter.use("read line"); }},
-                                    { Deception::Opcodes::TopLevelCodes::StartMakeString, [](auto& interpreter, char) { interpreter.use("read string"); } },
-                                    { Deception::Opcodes::TopLevelCodes::SkipNextCharacter, [](auto& interpreter, char) { interpreter.use("skip next character"); } },
-                                    { Deception::Opcodes::TopLevelCodes::SwitchToTableFromStack, [](auto& interpreter, char) { interpreter.useFromStack(); } },
-                                    { '.', Deception::displayTopItemOnDataStack },
-                                    { '?', Deception::displayCurrentTableContents },
-                                    { '(', [](auto& interpreter, char) { interpreter.use("multi line comment"); }},
-                            }
-                    }
+                    CustomTable { "core", std::make_shared<CoreTable>() },
+                    CustomTable { "memory", std::make_shared<Memory::Table>() },
             }
     };
-    theInterpreter.use("core");
-    std::cout << "CTRL-D to quit" << std::endl;
+    // scripts given on the command line are run in order before falling back to standard input
+    for (int i = argc - 1; i > 0; --i) {
+        if (!theInterpreter.useInputFile(argv[i])) {
+            std::cerr << "Unable to open " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    theInterpreter.use(Tables::Core);
+    theInterpreter.out() << "CTRL-D to quit\n";
     theInterpreter.run();
     return 0;
 }
@@ -0,0 +1,157 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/BatchRunner.h>
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace Deception {
+    namespace {
+        /**
+         * The queue of job indices owned by one worker, the owner takes from the back and thieves take from the front
+         * so they only meet when the queue is nearly empty
+         */
+        class WorkQueue {
+        public:
+            void push(std::size_t job) {
+                std::lock_guard guard(_lock);
+                _jobs.push_back(job);
+            }
+            bool pop(std::size_t& job) {
+                std::lock_guard guard(_lock);
+                if (_jobs.empty()) {
+                    return false;
+                }
+                job = _jobs.back();
+                _jobs.pop_back();
+                return true;
+            }
+            bool steal(std::size_t& job) {
+                std::lock_guard guard(_lock);
+                if (_jobs.empty()) {
+                    return false;
+                }
+                job = _jobs.front();
+                _jobs.pop_front();
+                return true;
+            }
+        private:
+            std::mutex _lock;
+            std::deque<std::size_t> _jobs;
+        };
+    } // end namespace
+    BatchRunner::BatchRunner(Interpreter::SharedConclave tables, BatchOptions options) : _tables(std::move(tables)), _options(options) {
+        if (!_tables || !_tables->contains(_options.entry)) {
+            throw std::invalid_argument("BatchRunner: the entry table is not in the conclave");
+        }
+        if (_options.workers == 0) {
+            _options.workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+    std::vector<BatchResult>
+    BatchRunner::run(const std::vector<BatchJob>& jobs) const {
+        std::vector<BatchResult> results(jobs.size());
+        auto workerCount = std::min(_options.workers, std::max<std::size_t>(jobs.size(), 1));
+        std::vector<WorkQueue> queues(workerCount);
+        // deal the jobs out in contiguous runs, the owner pops from the back so it works through its run in reverse
+        auto perWorker = (jobs.size() + workerCount - 1) / workerCount;
+        for (std::size_t i = jobs.size(); i > 0; --i) {
+            queues[(i - 1) / perWorker].push(i - 1);
+        }
+        auto work = [this, &jobs, &results, &queues, workerCount](std::size_t self) {
+            std::size_t job = 0;
+            // routines cache resolved actions as they run so each worker needs its own copy
+            std::optional<Interpreter::Routine> prelude;
+            if (!_options.prelude.empty()) {
+                prelude.emplace(_options.prelude);
+            }
+            while (true) {
+                bool found = queues[self].pop(job);
+                for (std::size_t offset = 1; !found && offset < workerCount; ++offset) {
+                    found = queues[(self + offset) % workerCount].steal(job);
+                }
+                if (!found) {
+                    // jobs never queue more jobs so once every queue is empty there is nothing left to do
+                    return;
+                }
+                results[job] = runJob(jobs[job], self, prelude ? &*prelude : nullptr);
+            }
+        };
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(workerCount - 1);
+            for (std::size_t i = 1; i < workerCount; ++i) {
+                threads.emplace_back(work, i);
+            }
+            work(0);
+        }
+        return results;
+    }
+    BatchResult
+    BatchRunner::runJob(const BatchJob& job, std::size_t worker, Interpreter::Routine* prelude) const {
+        using Clock = std::chrono::steady_clock;
+        BatchResult result;
+        result.name = job.name;
+        result.worker = worker;
+        auto start = Clock::now();
+        try {
+            Interpreter interpreter(_tables, {}, _options.memoryCapacity);
+            interpreter.setTraceMode(_options.trace);
+            if (_options.output) {
+                interpreter.setOutputSink(_options.output());
+            }
+            if (job.kind == BatchJob::Source::File) {
+                if (!interpreter.useInputFile(job.source)) {
+                    result.status = BatchStatus::InputUnavailable;
+                    result.error = "unable to open " + job.source;
+                    result.setup = Clock::now() - start;
+                    return result;
+                }
+            } else {
+                // the job outlives the interpreter so its code is read in place
+                interpreter.borrowInputStream(job.source);
+            }
+            interpreter.use(_options.entry);
+            auto running = Clock::now();
+            result.setup = running - start;
+            if (prelude) {
+                interpreter.execute(*prelude);
+            }
+            interpreter.run();
+            result.run = Clock::now() - running;
+            result.dataStack.assign(interpreter.dataStackBegin(), interpreter.dataStackEnd());
+            result.output = interpreter.getOutputSink().take();
+        } catch (const std::exception& e) {
+            result.status = BatchStatus::Failed;
+            result.error = e.what();
+        }
+        return result;
+    }
+} // end namespace Deception
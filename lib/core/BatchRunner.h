@@ -0,0 +1,112 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_BATCHRUNNER_H
+#define DECEPTION_BATCHRUNNER_H
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/Interpreter.h>
+namespace Deception {
+    /**
+     * @brief One independent script to run, either given directly as code or as the path of a file to map
+     */
+    struct BatchJob {
+        enum class Source {
+            Code,
+            File,
+        };
+        std::string name;
+        std::string source;
+        Source kind = Source::Code;
+        static BatchJob code(std::string name, std::string code) { return { std::move(name), std::move(code), Source::Code }; }
+        static BatchJob file(std::string name, std::string path) { return { std::move(name), std::move(path), Source::File }; }
+    };
+    enum class BatchStatus {
+        /// the script ran until it terminated or its input ran out
+        Completed,
+        /// the input file could not be opened
+        InputUnavailable,
+        /// an action threw an exception, the message is kept in the result
+        Failed,
+    };
+    struct BatchResult {
+        using Duration = std::chrono::nanoseconds;
+        std::string name;
+        BatchStatus status = BatchStatus::Completed;
+        std::string error;
+        /// the data stack when the job finished, bottom first
+        std::vector<Value> dataStack;
+        /// everything the job wrote to an in memory sink, empty for other sinks
+        std::string output;
+        /// time spent building the interpreter and opening the input
+        Duration setup { 0 };
+        /// time spent running the script
+        Duration run { 0 };
+        /// the worker which ran the job
+        std::size_t worker = 0;
+    };
+    struct BatchOptions {
+        /// number of worker threads, zero means one per hardware thread
+        std::size_t workers = 0;
+        /// the table each job starts in, it has to be set to a table in the conclave
+        TableHandle entry = InvalidTableHandle;
+        /// the memory space each interpreter gets, this is reserved and not committed so it is cheap to make big
+        Address memoryCapacity = 256 * 1024 * 1024;
+        TraceMode trace = TraceMode::Off;
+        /// code every job runs in the entry table before its own input, it is compiled once per worker and not per job
+        std::string prelude;
+        /// makes the output sink of each job, jobs run at the same time so they should not share a target
+        std::function<std::unique_ptr<OutputSink>()> output = [] { return OutputSink::memory(); };
+    };
+    /**
+     * @brief Runs many independent scripts in parallel against one shared conclave. Each job gets a fresh
+     * interpreter, jobs are dealt out to per worker queues up front and workers which run out of work steal from the
+     * others so a few slow jobs do not hold up the whole batch. The tables in the conclave must not change while a
+     * batch is running.
+     */
+    class BatchRunner {
+    public:
+        /**
+         * @throws std::invalid_argument if the entry table of the options is not in the conclave
+         */
+        BatchRunner(Interpreter::SharedConclave tables, BatchOptions options);
+        /**
+         * Run every job and wait for all of them to finish
+         * @return One result per job in the same order as the jobs
+         */
+        std::vector<BatchResult> run(const std::vector<BatchJob>& jobs) const;
+        [[nodiscard]] std::size_t workers() const noexcept { return _options.workers; }
+    private:
+        BatchResult runJob(const BatchJob& job, std::size_t worker, Interpreter::Routine* prelude) const;
+    private:
+        Interpreter::SharedConclave _tables;
+        BatchOptions _options;
+    };
+} // end namespace Deception
+#endif //DECEPTION_BATCHRUNNER_H
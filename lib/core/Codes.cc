@@ -23,23 +23,11 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <core/Table.h>
+#include <core/Codes.h>
 
 namespace Deception::Opcodes {
     std::string
     decode(char value) noexcept {
-        switch (value) {
-#define DeclareControlCode(name, code) case static_cast<char>(code) : return #name ;
-#define DeclareAlias(name, alias)
-#define StartGroup(name)
-#define EndGroup(name)
-#include <core/AsciiCodes.def>
-#undef DeclareAlias
-#undef DeclareControlCode
-#undef StartGroup
-#undef EndGroup
-            default:
-                return std::string{&value, 1};
-        }
+        return std::string { Codes[static_cast<unsigned char>(value)] };
     }
 } // end namespace Deception::Opcodes
\ No newline at end of file
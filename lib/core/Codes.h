@@ -28,7 +28,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #ifndef DECEPTION_CODES_H
 #define DECEPTION_CODES_H
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
 namespace Deception::Opcodes {
 #define DeclareControlCode(name, code) constexpr char name = static_cast<char>( code ) ;
 #define DeclareAlias(name, reference) DeclareControlCode(name, reference)
@@ -39,6 +44,144 @@ namespace Deception::Opcodes {
 #undef DeclareAlias
 #undef StartGroup
 #undef EndGroup
+/**
+ * @brief A name given to a code in AsciiCodes.def, group is empty for the Code_0xNN names declared outside of any group
+ */
+struct CodeName {
+    std::string_view group;
+    std::string_view name;
+    char code;
+};
+constexpr std::size_t CodeNameCount = 0
+#define DeclareControlCode(name, code) + 1
+#define DeclareAlias(name, reference) + 1
+#define StartGroup(name)
+#define EndGroup(name)
+#include <core/AsciiCodes.def>
+#undef DeclareControlCode
+#undef DeclareAlias
+#undef StartGroup
+#undef EndGroup
+;
+/**
+ * Every name in AsciiCodes.def in the order it was declared
+ */
+constexpr std::array<CodeName, CodeNameCount> CodeNames = [] {
+    std::array<CodeName, CodeNameCount> result { };
+    std::size_t index = 0;
+    constexpr std::string_view group { };
+#define DeclareControlCode(name, code) result[index++] = CodeName { group, #name, name };
+#define DeclareAlias(name, reference) DeclareControlCode(name, reference)
+#define StartGroup(name) { using namespace name; constexpr std::string_view group { #name };
+#define EndGroup(name) }
+#include <core/AsciiCodes.def>
+#undef DeclareControlCode
+#undef DeclareAlias
+#undef StartGroup
+#undef EndGroup
+    return result;
+}();
+using NameTable = std::array<std::string_view, 0x100>;
+/**
+ * Build a table of the names a group gives each code, when a group names a code more than once the first name wins
+ * @param group The group to collect, empty for the Code_0xNN names
+ * @return The names indexed by code, codes the group does not name are empty
+ */
+constexpr NameTable
+namesIn(std::string_view group) noexcept {
+    NameTable result { };
+    for (const auto& entry : CodeNames) {
+        if (auto& slot = result[static_cast<unsigned char>(entry.code)]; entry.group == group && slot.empty()) {
+            slot = entry.name;
+        }
+    }
+    return result;
+}
+constexpr NameTable Codes = namesIn({ });
+#define DeclareControlCode(name, code)
+#define DeclareAlias(name, reference)
+#define StartGroup(name) namespace name { constexpr NameTable Names = namesIn(#name);
+#define EndGroup(name) }
+#include <core/AsciiCodes.def>
+#undef DeclareControlCode
+#undef DeclareAlias
+#undef StartGroup
+#undef EndGroup
+namespace Detail {
+    constexpr std::array<char, 0x100> Characters = [] {
+        std::array<char, 0x100> result { };
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            result[i] = static_cast<char>(i);
+        }
+        return result;
+    }();
+    /**
+     * Positions in CodeNames sorted by name, names given more than once stay in declaration order
+     */
+    constexpr std::array<std::size_t, CodeNameCount> ByName = [] {
+        std::array<std::size_t, CodeNameCount> result { };
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            result[i] = i;
+        }
+        // std::stable_sort is not usable in constant expressions, an insertion sort is stable and the list is short
+        for (std::size_t i = 1; i < result.size(); ++i) {
+            for (auto j = i; j > 0 && CodeNames[result[j]].name < CodeNames[result[j - 1]].name; --j) {
+                std::swap(result[j], result[j - 1]);
+            }
+        }
+        return result;
+    }();
+} // end namespace Detail
+/**
+ * The name a disassembly should use for each code: printable characters stand for themselves, anything else uses the
+ * TopLevelCodes name, then the Ascii name, then the ANPA1312 name and finally the Code_0xNN name
+ */
+constexpr NameTable Mnemonics = [] {
+    NameTable result { };
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        if (i > 0x20 && i < 0x7f) {
+            result[i] = std::string_view { &Detail::Characters[i], 1 };
+        } else if (!TopLevelCodes::Names[i].empty()) {
+            result[i] = TopLevelCodes::Names[i];
+        } else if (!Ascii::Names[i].empty()) {
+            result[i] = Ascii::Names[i];
+        } else if (!ANPA1312::Names[i].empty()) {
+            result[i] = ANPA1312::Names[i];
+        } else {
+            result[i] = Codes[i];
+        }
+    }
+    return result;
+}();
+constexpr std::string_view mnemonic(char code) noexcept { return Mnemonics[static_cast<unsigned char>(code)]; }
+/**
+ * Find the code behind a name from AsciiCodes.def
+ * @param name Either a bare name (EOT, Code_0x04) or one qualified with its group (Ascii::EOT). A bare name given by
+ * more than one group resolves to the one declared first.
+ * @return The code or std::nullopt if nothing has that name
+ */
+constexpr std::optional<char>
+encode(std::string_view name) noexcept {
+    std::string_view group { };
+    bool qualified = false;
+    if (auto separator = name.rfind("::"); separator != std::string_view::npos) {
+        group = name.substr(0, separator);
+        name = name.substr(separator + 2);
+        qualified = true;
+    }
+    auto first = std::lower_bound(Detail::ByName.begin(), Detail::ByName.end(), name, [](std::size_t index, std::string_view value) { return CodeNames[index].name < value; });
+    for (auto i = first; i != Detail::ByName.end() && CodeNames[*i].name == name; ++i) {
+        if (!qualified || CodeNames[*i].group == group) {
+            return CodeNames[*i].code;
+        }
+    }
+    return std::nullopt;
+}
+static_assert(encode("Ascii::EOT") == Ascii::EOT && encode("SGC") == Ascii::SGC && encode("StartMakeString") == TopLevelCodes::StartMakeString);
+static_assert(Ascii::Names[static_cast<unsigned char>(Ascii::SGC)] == "SGC", "the first alias for a code is the one it is known by");
+/**
+ * @return The Code_0xNN name of the given character
+ */
 std::string decode(char input) noexcept;
 }
 #endif //DECEPTION_CODES_H
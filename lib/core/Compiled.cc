@@ -0,0 +1,94 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Compiled.h>
+#include <cerrno>
+#include <iostream>
+#include <fcntl.h>
+
+namespace Deception::Compiled {
+    bool
+    run(State& state, int fd, Dispatch dispatch) {
+        constexpr std::size_t BlockSize = 64 * 1024;
+        auto block = std::make_unique_for_overwrite<char[]>(BlockSize);
+        while (state.executing && !state.tables.empty()) {
+            state.sink->flush();
+            auto amount = ::read(fd, block.get(), BlockSize);
+            if (amount == 0) {
+                break;
+            } else if (amount < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            dispatch(state, block.get(), block.get() + amount);
+        }
+        state.sink->flush();
+        return true;
+    }
+    int
+    runMain(State& state, int argc, char** argv, Dispatch dispatch) {
+        for (int i = 1; i < argc && state.executing; ++i) {
+            auto fd = ::open(argv[i], O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                std::cerr << "Unable to open " << argv[i] << std::endl;
+                return 1;
+            }
+            auto result = run(state, fd, dispatch);
+            ::close(fd);
+            if (!result) {
+                std::cerr << "Unable to read " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        if (state.executing && !run(state, STDIN_FILENO, dispatch)) {
+            std::cerr << "Unable to read standard input" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    void
+    displayDataStack(State& state, char) {
+        auto& out = state.out();
+        if (state.dataStack.empty()) {
+            out << "data stack empty!\n";
+            return;
+        }
+        out << "top of stack\n";
+        for (std::size_t i = 0; i < state.dataStack.size(); ++i) {
+            if (const auto& value = state.dataStack.peek(i); value) {
+                std::visit([&out](auto&& contents) { out << "- " << contents << '\n'; }, *value);
+            } else {
+                out << "- null\n";
+            }
+        }
+        out << "bottom of stack\n";
+    }
+    void
+    clearDataStack(State& state, char) noexcept {
+        state.dataStack.clear();
+    }
+} // end namespace Deception::Compiled
@@ -0,0 +1,83 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_COMPILED_H
+#define DECEPTION_COMPILED_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <core/Value.h>
+#include <core/DataStack.h>
+#include <core/MemorySpace.h>
+#include <core/OutputSink.h>
+#include <core/Scan.h>
+/**
+ * Support for interpreters generated ahead of time by deception-codegen. A generated interpreter dispatches with a
+ * switch per table and keeps everything it needs in a State, there are no Table objects, no std::function and no
+ * virtual calls involved.
+ */
+namespace Deception::Compiled {
+    /**
+     * @brief Everything a generated interpreter works on, this mirrors the matching parts of Interpreter
+     */
+    struct State {
+        using TableId = std::uint32_t;
+        explicit State(Address capacity = (256 * 1024 * 1024)) : memory(capacity) { }
+        [[nodiscard]] std::ostream& out() noexcept { return sink->stream(); }
+        DataStack<Value> dataStack;
+        MemorySpace memory;
+        // the string being built, the same as the output stream of Interpreter
+        std::string output;
+        // the tables that have been used, the current one at the back
+        std::vector<TableId> tables;
+        std::unique_ptr<OutputSink> sink = OutputSink::fileDescriptor(STDOUT_FILENO);
+        bool executing = true;
+    };
+    /**
+     * Dispatch every character in [begin, end) and return where it stopped, which is before end only once the
+     * interpreter has terminated
+     */
+    using Dispatch = const char* (*)(State& state, const char* begin, const char* end);
+    /**
+     * Read the given descriptor a block at a time and dispatch it until the end of it is reached or the interpreter
+     * terminates. The output sink is flushed before each read since it may block.
+     * @return false if the descriptor could not be read
+     */
+    bool run(State& state, int fd, Dispatch dispatch);
+    /**
+     * Run each file named on the command line in order and then standard input, the same way the simple interpreter
+     * does
+     * @return The exit code for main
+     */
+    int runMain(State& state, int argc, char** argv, Dispatch dispatch);
+    /**
+     * Builtins which can be named by call in a conclave description
+     */
+    void displayDataStack(State& state, char);
+    void clearDataStack(State& state, char) noexcept;
+} // end namespace Deception::Compiled
+#endif //DECEPTION_COMPILED_H
@@ -28,47 +28,160 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #ifndef DECEPTION_CONCLAVE_H
 #define DECEPTION_CONCLAVE_H
+#include <cstdint>
+#include <limits>
 #include <map>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
 #include <core/Table.h>
 namespace Deception {
+    /**
+     * @brief A stable integer name for a table inside of a Conclave, handles are handed out in the order tables are
+     * registered starting from zero and never change afterwards
+     */
+    using TableHandle = std::uint32_t;
+    constexpr TableHandle InvalidTableHandle = std::numeric_limits<TableHandle>::max();
     template<typename Interpreter>
     class Conclave {
     public:
         using GenericTable_t = GenericTable<Interpreter>;
         using Table_t = Table<Interpreter>;
+        using DenseTable_t = DenseTable<Interpreter>;
         using TableReference = Table_t::SharedPtr;
         using GenericTableReference = GenericTable_t::SharedPtr;
-        using BackingStore = std::map<std::string, GenericTableReference>;
+        using BackingStore = std::map<std::string, TableHandle, std::less<>>;
         using GenericInputEntry = std::pair<typename BackingStore::key_type, Table_t>;
+        using DenseInputEntry = std::pair<typename BackingStore::key_type, DenseTable_t>;
         using CustomInputEntry = std::pair<typename BackingStore::key_type, GenericTableReference>;
-        using InputEntry = std::variant<GenericInputEntry, CustomInputEntry>;
+        using InputEntry = std::variant<GenericInputEntry, DenseInputEntry, CustomInputEntry>;
         Conclave() = default;
+        /**
+         * Build a conclave out of the given tables, the first table gets handle 0, the second handle 1 and so on.
+         * If a name is given more than once the name refers to the first table, the later tables still take up a
+         * handle so handles always match the order of the list.
+         */
         Conclave(std::initializer_list<InputEntry> list) {
+            _tables.reserve(list.size());
             for (auto& a : list) {
                 std::visit([this](auto&& a) {
                     using K = std::decay_t<decltype(a)>;
                     if constexpr (std::is_same_v<K, GenericInputEntry>) {
-                        _backingStore.emplace(a.first, std::make_shared<Table_t>(a.second));
+                        insert(a.first, std::make_shared<Table_t>(a.second));
+                    } else if constexpr (std::is_same_v<K, DenseInputEntry>) {
+                        insert(a.first, std::make_shared<DenseTable_t>(a.second));
                     } else {
-                        _backingStore.emplace(a.first, a.second);
+                        insert(a.first, a.second);
                     }
                 }, a);
             }
         }
         Conclave(const Conclave&) = default;
         Conclave(Conclave&&) = default;
-        auto size() const noexcept { return _backingStore.size(); }
-        auto operator[](const BackingStore::key_type& index) noexcept { return _backingStore[index]; }
-        auto operator[](BackingStore::key_type&& index) noexcept { return _backingStore[index]; }
-        GenericTableReference find(const BackingStore::key_type&  name)  {
-            if (auto result = _backingStore.find(name); result != _backingStore.end()) {
+        auto size() const noexcept { return _handles.size(); }
+        /**
+         * The number of handles handed out, this includes tables adopted without a name
+         */
+        [[nodiscard]] std::size_t handleCount() const noexcept { return _tables.size(); }
+        auto operator[](const BackingStore::key_type& index) noexcept { return reference(slot(index)); }
+        auto operator[](BackingStore::key_type&& index) noexcept { return reference(slot(index)); }
+        GenericTableReference find(std::string_view name) const {
+            return reference(handleOf(name));
+        }
+        /**
+         * Register a table under the given name
+         * @return The handle of the new table, if the name was already taken the existing handle is returned and the
+         * new table is only stored if the existing entry was empty
+         */
+        TableHandle add(const BackingStore::key_type& name, GenericTableReference table) {
+            if (auto result = _handles.find(name); result != _handles.end()) {
+                if (!_tables[result->second]) {
+                    _tables[result->second] = std::move(table);
+                }
+                return result->second;
+            }
+            auto handle = append(std::move(table));
+            _handles.emplace(name, handle);
+            _names.back() = name;
+            return handle;
+        }
+        /**
+         * Get a handle for a table which may not have been registered by name, unnamed tables get a handle as well
+         * @return The handle of the table or InvalidTableHandle if the table is null
+         */
+        TableHandle adopt(const GenericTableReference& table) {
+            if (!table) {
+                return InvalidTableHandle;
+            }
+            if (auto handle = handleOf(table); handle != InvalidTableHandle) {
+                return handle;
+            }
+            return append(table);
+        }
+        /**
+         * @return The handle of the given table or InvalidTableHandle if it was never registered or adopted
+         */
+        [[nodiscard]] TableHandle handleOf(const GenericTableReference& table) const noexcept {
+            for (TableHandle i = 0; i < _tables.size(); ++i) {
+                if (_tables[i] == table) {
+                    return i;
+                }
+            }
+            return InvalidTableHandle;
+        }
+        /**
+         * @return The handle of the named table or InvalidTableHandle if there is no such table
+         */
+        [[nodiscard]] TableHandle handleOf(std::string_view name) const noexcept {
+            if (auto result = _handles.find(name); result != _handles.end()) {
                 return result->second;
             } else {
-                return nullptr;
+                return InvalidTableHandle;
+            }
+        }
+        [[nodiscard]] bool contains(TableHandle handle) const noexcept { return handle < _tables.size() && _tables[handle]; }
+        /**
+         * Get the table behind a handle without touching any reference counts, the handle must be valid
+         */
+        [[nodiscard]] GenericTable_t* get(TableHandle handle) const noexcept { return _tables[handle].get(); }
+        [[nodiscard]] GenericTableReference reference(TableHandle handle) const noexcept { return handle < _tables.size() ? _tables[handle] : nullptr; }
+        /**
+         * Find the name a table was registered under
+         * @return The name of the table or std::nullopt if it is not part of this conclave or was never named
+         */
+        std::optional<typename BackingStore::key_type> nameOf(TableHandle handle) const {
+            if (handle < _names.size() && !_names[handle].empty()) {
+                return _names[handle];
+            } else {
+                return std::nullopt;
+            }
+        }
+        std::optional<typename BackingStore::key_type> nameOf(const GenericTableReference& table) const {
+            return nameOf(handleOf(table));
+        }
+    private:
+        void insert(const BackingStore::key_type& name, GenericTableReference table) {
+            auto handle = append(std::move(table));
+            if (_handles.emplace(name, handle).second) {
+                _names[handle] = name;
+            }
+        }
+        TableHandle append(GenericTableReference table) {
+            _tables.emplace_back(std::move(table));
+            _names.emplace_back();
+            return static_cast<TableHandle>(_tables.size() - 1);
+        }
+        TableHandle slot(const BackingStore::key_type& name) {
+            if (auto handle = handleOf(name); handle != InvalidTableHandle) {
+                return handle;
             }
+            return add(name, nullptr);
         }
     private:
-        BackingStore _backingStore;
+        BackingStore _handles;
+        std::vector<GenericTableReference> _tables;
+        std::vector<std::string> _names;
     };
 } // end namespace Deception
 
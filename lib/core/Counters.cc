@@ -0,0 +1,86 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Counters.h>
+#include <core/Json.h>
+#include <numeric>
+
+namespace Deception {
+    DispatchCounters<true>::Count
+    DispatchCounters<true>::dispatches(TableHandle table) const noexcept {
+        if (table >= _tables.size()) {
+            return 0;
+        }
+        const auto& counts = _tables[table].dispatches;
+        return std::accumulate(counts.begin(), counts.end(), Count { 0 });
+    }
+    DispatchCounters<true>::Count
+    DispatchCounters<true>::dispatches() const noexcept {
+        Count total = 0;
+        for (TableHandle i = 0; i < _tables.size(); ++i) {
+            total += dispatches(i);
+        }
+        return total;
+    }
+    void
+    DispatchCounters<true>::reset() noexcept {
+        _tables.clear();
+        _streamPushes = 0;
+        _streamPops = 0;
+        _dataStackHighWater = 0;
+    }
+    void
+    DispatchCounters<true>::writeJson(std::ostream& out, const std::vector<std::optional<std::string>>& names) const {
+        out << "{\"enabled\": true"
+            << ", \"dispatches\": " << dispatches()
+            << ", \"stream_pushes\": " << _streamPushes
+            << ", \"stream_pops\": " << _streamPops
+            << ", \"data_stack_high_water\": " << _dataStackHighWater
+            << ", \"tables\": [";
+        bool firstTable = true;
+        for (TableHandle i = 0; i < _tables.size(); ++i) {
+            const auto& counts = _tables[i];
+            out << (firstTable ? "" : ", ") << "{\"handle\": " << i;
+            firstTable = false;
+            if (i < names.size() && names[i]) {
+                out << ", \"name\": \"" << jsonEscape(*names[i]) << "\"";
+            }
+            out << ", \"entries\": " << counts.entries
+                << ", \"exits\": " << counts.exits
+                << ", \"fallbacks\": " << counts.fallbacks
+                << ", \"dispatches\": {";
+            // keyed by character code so nothing needs to be escaped
+            bool firstCode = true;
+            for (std::size_t code = 0; code < counts.dispatches.size(); ++code) {
+                if (counts.dispatches[code] != 0) {
+                    out << (firstCode ? "" : ", ") << "\"" << code << "\": " << counts.dispatches[code];
+                    firstCode = false;
+                }
+            }
+            out << "}}";
+        }
+        out << "]}";
+    }
+} // end namespace Deception
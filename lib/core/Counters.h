@@ -0,0 +1,140 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_COUNTERS_H
+#define DECEPTION_COUNTERS_H
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <core/Conclave.h>
+namespace Deception {
+    /**
+     * @brief Counts what an interpreter spends its time on: dispatches per (table, character), fallbacks to a
+     * table's default implementation, table enters and leaves, input stream pushes and pops and the deepest the data
+     * stack has been. The disabled specialization does nothing so every call compiles away.
+     * @tparam Enabled Should anything actually be counted
+     */
+    template<bool Enabled>
+    class DispatchCounters;
+
+    template<>
+    class DispatchCounters<true> {
+    public:
+        static constexpr bool enabled = true;
+        using Count = std::uint64_t;
+        // counting for a table which has not been seen yet allocates its counts, so these can throw std::bad_alloc
+        void dispatched(TableHandle table, char c) { ++slot(table).dispatches[static_cast<unsigned char>(c)]; }
+        void fellBack(TableHandle table) { ++slot(table).fallbacks; }
+        /**
+         * A run of characters consumed in one go, none of them had an entry in the table
+         */
+        void consumed(TableHandle table, std::string_view span) {
+            auto& counts = slot(table);
+            for (auto c : span) {
+                ++counts.dispatches[static_cast<unsigned char>(c)];
+            }
+            counts.fallbacks += span.size();
+        }
+        void entered(TableHandle table) { ++slot(table).entries; }
+        void left(TableHandle table) { ++slot(table).exits; }
+        void streamPushed() noexcept { ++_streamPushes; }
+        void streamPopped() noexcept { ++_streamPops; }
+        void dataStackDepth(std::size_t depth) noexcept { _dataStackHighWater = std::max<Count>(_dataStackHighWater, depth); }
+        [[nodiscard]] Count dispatches(TableHandle table, char c) const noexcept { return table < _tables.size() ? _tables[table].dispatches[static_cast<unsigned char>(c)] : 0; }
+        [[nodiscard]] Count dispatches(TableHandle table) const noexcept;
+        [[nodiscard]] Count dispatches() const noexcept;
+        [[nodiscard]] Count fallbacks(TableHandle table) const noexcept { return table < _tables.size() ? _tables[table].fallbacks : 0; }
+        [[nodiscard]] Count entries(TableHandle table) const noexcept { return table < _tables.size() ? _tables[table].entries : 0; }
+        [[nodiscard]] Count exits(TableHandle table) const noexcept { return table < _tables.size() ? _tables[table].exits : 0; }
+        [[nodiscard]] Count streamPushes() const noexcept { return _streamPushes; }
+        [[nodiscard]] Count streamPops() const noexcept { return _streamPops; }
+        [[nodiscard]] Count dataStackHighWater() const noexcept { return _dataStackHighWater; }
+        void reset() noexcept;
+        /**
+         * Write every counter out as a single JSON object
+         * @param out Where to write the JSON
+         * @param names The name of each table indexed by handle, unnamed tables are written without a name
+         */
+        void writeJson(std::ostream& out, const std::vector<std::optional<std::string>>& names) const;
+    private:
+        struct TableCounts {
+            std::array<Count, 0x100> dispatches { };
+            Count fallbacks = 0;
+            Count entries = 0;
+            Count exits = 0;
+        };
+        TableCounts& slot(TableHandle table) {
+            if (table >= _tables.size()) {
+                _tables.resize(static_cast<std::size_t>(table) + 1);
+            }
+            return _tables[table];
+        }
+    private:
+        std::vector<TableCounts> _tables;
+        Count _streamPushes = 0;
+        Count _streamPops = 0;
+        Count _dataStackHighWater = 0;
+    };
+
+    template<>
+    class DispatchCounters<false> {
+    public:
+        static constexpr bool enabled = false;
+        using Count = std::uint64_t;
+        void dispatched(TableHandle, char) noexcept { }
+        void fellBack(TableHandle) noexcept { }
+        void consumed(TableHandle, std::string_view) noexcept { }
+        void entered(TableHandle) noexcept { }
+        void left(TableHandle) noexcept { }
+        void streamPushed() noexcept { }
+        void streamPopped() noexcept { }
+        void dataStackDepth(std::size_t) noexcept { }
+        [[nodiscard]] constexpr Count dispatches(TableHandle, char) const noexcept { return 0; }
+        [[nodiscard]] constexpr Count dispatches(TableHandle) const noexcept { return 0; }
+        [[nodiscard]] constexpr Count dispatches() const noexcept { return 0; }
+        [[nodiscard]] constexpr Count fallbacks(TableHandle) const noexcept { return 0; }
+        [[nodiscard]] constexpr Count entries(TableHandle) const noexcept { return 0; }
+        [[nodiscard]] constexpr Count exits(TableHandle) const noexcept { return 0; }
+        [[nodiscard]] constexpr Count streamPushes() const noexcept { return 0; }
+        [[nodiscard]] constexpr Count streamPops() const noexcept { return 0; }
+        [[nodiscard]] constexpr Count dataStackHighWater() const noexcept { return 0; }
+        void reset() noexcept { }
+        void writeJson(std::ostream& out, const std::vector<std::optional<std::string>>&) const { out << "{\"enabled\": false}"; }
+    };
+    /**
+     * Counters are only collected when the library is built with DECEPTION_ENABLE_COUNTERS
+     */
+#ifdef DECEPTION_ENABLE_COUNTERS
+    using Counters = DispatchCounters<true>;
+#else
+    using Counters = DispatchCounters<false>;
+#endif
+} // end namespace Deception
+#endif //DECEPTION_COUNTERS_H
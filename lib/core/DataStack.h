@@ -0,0 +1,126 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_DATASTACK_H
+#define DECEPTION_DATASTACK_H
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+namespace Deception {
+    /**
+     * @brief A stack which keeps its elements in one contiguous block. Space is reserved up front so pushing, popping
+     * and peeking do not allocate until the reserved capacity has been exceeded. The bottom of the stack is at begin()
+     * and the top is at rbegin(), the same as the std::list it replaces.
+     * @tparam T The type of element stored
+     */
+    template<typename T>
+    class DataStack {
+    public:
+        using Storage = std::vector<T>;
+        using value_type = T;
+        using size_type = typename Storage::size_type;
+        static constexpr size_type DefaultCapacity = 1024;
+        explicit DataStack(size_type reserved = DefaultCapacity) { _storage.reserve(reserved); }
+        void reserve(size_type amount) { _storage.reserve(amount); }
+        [[nodiscard]] size_type capacity() const noexcept { return _storage.capacity(); }
+        [[nodiscard]] size_type size() const noexcept { return _storage.size(); }
+        [[nodiscard]] bool empty() const noexcept { return _storage.empty(); }
+        void clear() noexcept { _storage.clear(); }
+        void push(const T& value) { _storage.push_back(value); }
+        void push(T&& value) { _storage.push_back(std::move(value)); }
+        template<typename ... Args>
+        T& emplace(Args&&... args) { return _storage.emplace_back(std::forward<Args>(args)...); }
+        /**
+         * Remove the top element and hand it back, the stack must not be empty
+         */
+        T pop() {
+            T result = std::move(_storage.back());
+            _storage.pop_back();
+            return result;
+        }
+        /**
+         * Get an element relative to the top of the stack (0 is the top), depth must be less than size()
+         */
+        [[nodiscard]] T& peek(size_type depth = 0) noexcept { return _storage[_storage.size() - 1 - depth]; }
+        [[nodiscard]] const T& peek(size_type depth = 0) const noexcept { return _storage[_storage.size() - 1 - depth]; }
+        [[nodiscard]] T& operator[](size_type depth) noexcept { return peek(depth); }
+        [[nodiscard]] const T& operator[](size_type depth) const noexcept { return peek(depth); }
+        /**
+         * Push a copy of the top count elements, keeping their order (dup when count is 1, 2dup when count is 2)
+         * @return false if there are fewer than count elements on the stack
+         */
+        bool dup(size_type count = 1) {
+            if (count > size()) {
+                return false;
+            }
+            _storage.reserve(size() + count);
+            auto start = _storage.size() - count;
+            for (size_type i = 0; i < count; ++i) {
+                _storage.push_back(_storage[start + i]);
+            }
+            return true;
+        }
+        /**
+         * Remove the top count elements
+         * @return false if there are fewer than count elements on the stack
+         */
+        bool drop(size_type count = 1) {
+            if (count > size()) {
+                return false;
+            }
+            _storage.resize(size() - count);
+            return true;
+        }
+        /**
+         * Exchange the top count elements with the count elements underneath them (swap when count is 1, 2swap when
+         * count is 2)
+         * @return false if there are fewer than twice count elements on the stack
+         */
+        bool swap(size_type count = 1) {
+            if (count * 2 > size()) {
+                return false;
+            }
+            auto top = _storage.end() - count;
+            std::swap_ranges(top - count, top, top);
+            return true;
+        }
+        auto begin() noexcept { return _storage.begin(); }
+        auto begin() const noexcept { return _storage.begin(); }
+        auto cbegin() const noexcept { return _storage.cbegin(); }
+        auto end() noexcept { return _storage.end(); }
+        auto end() const noexcept { return _storage.end(); }
+        auto cend() const noexcept { return _storage.cend(); }
+        auto rbegin() noexcept { return _storage.rbegin(); }
+        auto rbegin() const noexcept { return _storage.rbegin(); }
+        auto crbegin() const noexcept { return _storage.crbegin(); }
+        auto rend() noexcept { return _storage.rend(); }
+        auto rend() const noexcept { return _storage.rend(); }
+        auto crend() const noexcept { return _storage.crend(); }
+    private:
+        Storage _storage;
+    };
+} // end namespace Deception
+#endif //DECEPTION_DATASTACK_H
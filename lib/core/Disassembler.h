@@ -0,0 +1,102 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_DISASSEMBLER_H
+#define DECEPTION_DISASSEMBLER_H
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <core/Codes.h>
+namespace Deception {
+    /**
+     * @brief Renders a stream of codes one per line using Opcodes::mnemonic. Lines are collected in a fixed buffer and
+     * handed to the output stream a block at a time so arbitrarily long traces can be written without allocating per
+     * code.
+     */
+    class TraceDisassembler {
+    public:
+        static constexpr std::size_t DefaultBufferSize = 64 * 1024;
+        explicit TraceDisassembler(std::ostream& out, std::size_t bufferSize = DefaultBufferSize);
+        TraceDisassembler(const TraceDisassembler&) = delete;
+        TraceDisassembler& operator=(const TraceDisassembler&) = delete;
+        /**
+         * Anything still buffered is written out
+         */
+        ~TraceDisassembler();
+        void write(char code) {
+            append(Opcodes::mnemonic(code));
+            append('\n');
+            ++_lines;
+        }
+        /**
+         * Write a code prefixed with the table which handled it
+         */
+        void write(std::string_view table, char code) {
+            append(table);
+            append('\t');
+            write(code);
+        }
+        /**
+         * Write every code in the given sequence, the output of Interpreter::getPreviousExecution for instance
+         */
+        void write(std::string_view codes) {
+            for (auto c : codes) {
+                write(c);
+            }
+        }
+        /**
+         * Hand everything buffered so far to the output stream
+         */
+        void flush();
+        [[nodiscard]] std::uint64_t lines() const noexcept { return _lines; }
+    private:
+        void append(char c) {
+            if (_used == _capacity) {
+                flush();
+            }
+            _buffer[_used++] = c;
+        }
+        void append(std::string_view text) {
+            if (text.size() > _capacity - _used) {
+                flush();
+                if (text.size() > _capacity) {
+                    _out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                    return;
+                }
+            }
+            std::memcpy(_buffer.get() + _used, text.data(), text.size());
+            _used += text.size();
+        }
+    private:
+        std::ostream& _out;
+        std::size_t _capacity;
+        std::size_t _used = 0;
+        std::unique_ptr<char[]> _buffer;
+        std::uint64_t _lines = 0;
+    };
+} // end namespace Deception
+#endif //DECEPTION_DISASSEMBLER_H
@@ -0,0 +1,240 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_EXECUTIONTRACE_H
+#define DECEPTION_EXECUTIONTRACE_H
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+namespace Deception {
+    /**
+     * @brief How much of the execution history an interpreter should keep around
+     */
+    enum class TraceMode {
+        /// do not record anything
+        Off,
+        /// keep the last N events in a fixed size ring buffer
+        Ring,
+        /// keep every event, this grows without bound so only use it for short runs
+        Full,
+    };
+    /**
+     * @brief Records the characters an interpreter dispatched along with the table that handled each one.
+     * The ring mode never allocates after it has been configured and is lock free for a single writer: each slot is
+     * written with relaxed atomics and the write index is published with release ordering, so another thread can
+     * take a snapshot while the interpreter keeps recording. A snapshot leaves out any event the writer may have
+     * overwritten while it was being copied. Full mode grows a vector, reading it while it is recorded into needs a
+     * lock around both sides, as does changing the mode.
+     * @tparam TableReference How a table is identified in each event
+     */
+    template<typename TableReference>
+    class ExecutionTrace {
+        static_assert(std::is_trivially_copyable_v<TableReference>, "table references are stored in atomics");
+    public:
+        static constexpr std::size_t DefaultCapacity = 4096;
+        struct Event {
+            TableReference table;
+            char character;
+        };
+        explicit ExecutionTrace(TraceMode mode = TraceMode::Full, std::size_t capacity = DefaultCapacity) { configure(mode, capacity); }
+        ExecutionTrace(const ExecutionTrace& other) : _mode(other._mode), _events(other._events) {
+            if (_mode == TraceMode::Ring) {
+                allocateRing(other._capacity);
+            }
+            _floor.store(other._floor.load(std::memory_order_acquire), std::memory_order_relaxed);
+            _written.store(other._written.load(std::memory_order_acquire), std::memory_order_relaxed);
+            for (std::size_t i = 0; i <= _mask && _ring; ++i) {
+                _ring[i].table.store(other._ring[i].table.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                _ring[i].character.store(other._ring[i].character.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+        /**
+         * Change the trace mode, this throws away everything recorded so far
+         * @param mode The new mode
+         * @param capacity The number of events to keep in ring mode (rounded up to a power of two)
+         */
+        void configure(TraceMode mode, std::size_t capacity = DefaultCapacity) {
+            _mode = mode;
+            _events.clear();
+            _events.shrink_to_fit();
+            _ring.reset();
+            _capacity = 0;
+            _mask = 0;
+            _floor.store(0, std::memory_order_relaxed);
+            _written.store(0, std::memory_order_release);
+            if (mode == TraceMode::Ring) {
+                allocateRing(std::bit_ceil(capacity == 0 ? 1 : capacity));
+            }
+        }
+        void record(TableReference table, char character) {
+            switch (_mode) {
+                case TraceMode::Ring: {
+                    auto index = _written.load(std::memory_order_relaxed);
+                    put(index, table, character);
+                    _written.store(index + 1, std::memory_order_release);
+                    break;
+                }
+                case TraceMode::Full:
+                    _events.push_back(Event { table, character });
+                    _written.store(_events.size(), std::memory_order_relaxed);
+                    break;
+                default:
+                    break;
+            }
+        }
+        /**
+         * Record a run of characters which were all handled by the same table
+         */
+        void record(TableReference table, std::string_view characters) {
+            switch (_mode) {
+                case TraceMode::Ring: {
+                    auto index = _written.load(std::memory_order_relaxed);
+                    // only the tail of a long run can survive in the ring, the slots of the rest are never written so
+                    // readers are told to skip them before they become part of the retained range
+                    if (characters.size() > _capacity) {
+                        index += characters.size() - _capacity;
+                        characters.remove_prefix(characters.size() - _capacity);
+                        _floor.store(index, std::memory_order_relaxed);
+                        _written.store(index, std::memory_order_release);
+                    }
+                    // published one event at a time so a reader never has to guess how far ahead the writer is
+                    for (auto c : characters) {
+                        put(index, table, c);
+                        _written.store(++index, std::memory_order_release);
+                    }
+                    break;
+                }
+                case TraceMode::Full:
+                    for (auto c : characters) {
+                        _events.push_back(Event { table, c });
+                    }
+                    _written.store(_events.size(), std::memory_order_relaxed);
+                    break;
+                default:
+                    break;
+            }
+        }
+        [[nodiscard]] constexpr TraceMode mode() const noexcept { return _mode; }
+        /**
+         * @return The total number of events recorded since the last configure, including ones that have been overwritten
+         */
+        [[nodiscard]] std::uint64_t recorded() const noexcept { return _written.load(std::memory_order_acquire); }
+        /**
+         * @return The number of events that can be retrieved right now
+         */
+        [[nodiscard]] std::size_t size() const noexcept {
+            if (_mode != TraceMode::Ring) {
+                return _events.size();
+            }
+            auto end = recorded();
+            return static_cast<std::size_t>(end - std::max(_floor.load(std::memory_order_relaxed), end > _capacity ? end - _capacity : 0));
+        }
+        /**
+         * Walk the retained events from oldest to newest, in ring mode this walks a snapshot
+         */
+        template<typename F>
+        void forEach(F&& fn) const {
+            if (_mode == TraceMode::Ring) {
+                for (const auto& event : events()) {
+                    fn(event);
+                }
+            } else {
+                for (const auto& event : _events) {
+                    fn(event);
+                }
+            }
+        }
+        /**
+         * @return The retained events from oldest to newest
+         */
+        [[nodiscard]] std::vector<Event> events() const {
+            if (_mode != TraceMode::Ring) {
+                return _events;
+            }
+            auto end = _written.load(std::memory_order_acquire);
+            auto begin = std::max(_floor.load(std::memory_order_relaxed), end > _capacity ? end - _capacity : 0);
+            std::vector<Event> result;
+            result.reserve(static_cast<std::size_t>(end - begin));
+            for (auto i = begin; i < end; ++i) {
+                const auto& slot = _ring[i & _mask];
+                result.push_back(Event { slot.table.load(std::memory_order_relaxed), slot.character.load(std::memory_order_relaxed) });
+            }
+            // pairs with the fence in put: if any slot read above was overwritten, the index read below has moved on
+            // far enough to say so. The writer may also be part way through the slot of the index it is about to
+            // publish, anything that slot held is dropped as well.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto after = _written.load(std::memory_order_relaxed);
+            auto slots = _mask + 1;
+            auto valid = std::max(_floor.load(std::memory_order_relaxed), after + 1 > slots ? after + 1 - slots : 0);
+            if (valid > begin) {
+                result.erase(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(std::min<std::uint64_t>(valid - begin, result.size())));
+            }
+            return result;
+        }
+        /**
+         * @return The retained characters from oldest to newest without any table information
+         */
+        [[nodiscard]] std::string characters() const {
+            std::string result;
+            result.reserve(size());
+            forEach([&result](const Event& e) { result.push_back(e.character); });
+            return result;
+        }
+    private:
+        struct Slot {
+            std::atomic<TableReference> table { };
+            std::atomic<char> character { };
+        };
+        void allocateRing(std::size_t capacity) {
+            // twice as many slots as events are kept so the slot the writer is filling in is never one a reader wants
+            _ring = std::make_unique<Slot[]>(capacity * 2);
+            _capacity = capacity;
+            _mask = capacity * 2 - 1;
+        }
+        void put(std::uint64_t index, TableReference table, char character) noexcept {
+            // orders the publication of the previous index before the slot is overwritten, see events()
+            std::atomic_thread_fence(std::memory_order_release);
+            auto& slot = _ring[index & _mask];
+            slot.table.store(table, std::memory_order_relaxed);
+            slot.character.store(character, std::memory_order_relaxed);
+        }
+    private:
+        TraceMode _mode = TraceMode::Off;
+        std::size_t _capacity = 0;
+        std::size_t _mask = 0;
+        std::unique_ptr<Slot[]> _ring;
+        std::vector<Event> _events;
+        // events below the floor were skipped over by a long run and never written
+        std::atomic<std::uint64_t> _floor { 0 };
+        std::atomic<std::uint64_t> _written { 0 };
+    };
+} // end namespace Deception
+#endif //DECEPTION_EXECUTIONTRACE_H
@@ -0,0 +1,217 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Image.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Deception {
+    namespace {
+        std::size_t
+        pageSize() noexcept {
+            static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+        constexpr std::uint64_t
+        alignUp(std::uint64_t value, std::uint64_t alignment) noexcept {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+        /**
+         * Does a section of count records of the given size starting at offset lie inside a file of the given size,
+         * checked without anything being able to overflow
+         */
+        constexpr bool
+        sectionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t recordSize, std::uint64_t fileSize) noexcept {
+            return offset <= fileSize && count <= (fileSize - offset) / recordSize;
+        }
+        bool
+        writeAll(int fd, const void* data, std::size_t length, std::uint64_t offset) noexcept {
+            auto* current = static_cast<const char*>(data);
+            while (length > 0) {
+                auto amount = ::pwrite(fd, current, length, static_cast<off_t>(offset));
+                if (amount <= 0) {
+                    return false;
+                }
+                current += amount;
+                offset += static_cast<std::uint64_t>(amount);
+                length -= static_cast<std::size_t>(amount);
+            }
+            return true;
+        }
+        bool
+        readAll(int fd, void* data, std::size_t length, std::uint64_t offset) noexcept {
+            auto* current = static_cast<char*>(data);
+            while (length > 0) {
+                auto amount = ::pread(fd, current, length, static_cast<off_t>(offset));
+                if (amount <= 0) {
+                    return false;
+                }
+                current += amount;
+                offset += static_cast<std::uint64_t>(amount);
+                length -= static_cast<std::size_t>(amount);
+            }
+            return true;
+        }
+    }
+    bool
+    saveImage(const std::string& path, const MemorySpace& memory, const DataStack<Value>& dataStack, const std::vector<std::string>& tableStack) {
+        std::vector<ImageValueRecord> values;
+        std::vector<ImageStringRecord> tables;
+        std::string strings;
+        values.reserve(dataStack.size());
+        for (const auto& value : dataStack) {
+            ImageValueRecord record { };
+            record.kind = static_cast<std::uint8_t>(value.kind());
+            switch (value.kind()) {
+                case Value::Kind::String: {
+                    auto str = value.asString();
+                    record.payload = strings.size();
+                    record.length = static_cast<std::uint32_t>(str.size());
+                    strings.append(str);
+                    break;
+                }
+                case Value::Kind::Integer: record.payload = static_cast<std::uint64_t>(value.asInteger()); break;
+                case Value::Kind::Ordinal: record.payload = value.asOrdinal(); break;
+                case Value::Kind::Character: record.payload = static_cast<unsigned char>(value.asCharacter()); break;
+                case Value::Kind::Boolean: record.payload = value.asBoolean() ? 1 : 0; break;
+                default: break;
+            }
+            values.push_back(record);
+        }
+        for (const auto& name : tableStack) {
+            tables.push_back({ strings.size(), name.size() });
+            strings.append(name);
+        }
+        ImageHeader header { };
+        header.magic = ImageHeader::ExpectedMagic;
+        header.version = ImageHeader::CurrentVersion;
+        header.byteOrder = ImageHeader::ByteOrderMark;
+        header.dataStackOffset = sizeof(ImageHeader);
+        header.dataStackCount = values.size();
+        header.tableStackOffset = header.dataStackOffset + values.size() * sizeof(ImageValueRecord);
+        header.tableStackCount = tables.size();
+        header.stringsOffset = header.tableStackOffset + tables.size() * sizeof(ImageStringRecord);
+        header.stringsSize = strings.size();
+        header.memoryOffset = alignUp(header.stringsOffset + header.stringsSize, pageSize());
+        header.memorySize = memory.size();
+
+        auto temporary = path + ".tmp";
+        int fd = ::open(temporary.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = writeAll(fd, &header, sizeof(header), 0) &&
+                  writeAll(fd, values.data(), values.size() * sizeof(ImageValueRecord), header.dataStackOffset) &&
+                  writeAll(fd, tables.data(), tables.size() * sizeof(ImageStringRecord), header.tableStackOffset) &&
+                  writeAll(fd, strings.data(), strings.size(), header.stringsOffset) &&
+                  ::ftruncate(fd, static_cast<off_t>(header.memoryOffset + header.memorySize)) == 0 &&
+                  memory.writeTo(fd, header.memoryOffset);
+        ok = (::close(fd) == 0) && ok;
+        if (ok) {
+            ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+        if (!ok) {
+            ::unlink(temporary.c_str());
+        }
+        return ok;
+    }
+
+    std::optional<ImageContents>
+    loadImage(const std::string& path, MappingMode mode) {
+        int fd = ::open(path.c_str(), (mode == MappingMode::Shared ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+        auto cleanup = [fd]() { ::close(fd); };
+        ImageHeader header { };
+        struct stat info { };
+        if (::fstat(fd, &info) != 0 ||
+            !readAll(fd, &header, sizeof(header), 0) ||
+            header.magic != ImageHeader::ExpectedMagic ||
+            header.version != ImageHeader::CurrentVersion ||
+            header.byteOrder != ImageHeader::ByteOrderMark ||
+            header.memoryOffset % pageSize() != 0 ||
+            // every section is checked against the file before anything is allocated for it, a corrupt header must
+            // not be able to ask for more than the file holds
+            !sectionFits(header.dataStackOffset, header.dataStackCount, sizeof(ImageValueRecord), static_cast<std::uint64_t>(info.st_size)) ||
+            !sectionFits(header.tableStackOffset, header.tableStackCount, sizeof(ImageStringRecord), static_cast<std::uint64_t>(info.st_size)) ||
+            !sectionFits(header.stringsOffset, header.stringsSize, 1, static_cast<std::uint64_t>(info.st_size)) ||
+            !sectionFits(header.memoryOffset, header.memorySize, 1, static_cast<std::uint64_t>(info.st_size))) {
+            cleanup();
+            return std::nullopt;
+        }
+        std::vector<ImageValueRecord> values(header.dataStackCount);
+        std::vector<ImageStringRecord> tables(header.tableStackCount);
+        std::string strings(header.stringsSize, '\0');
+        if (!readAll(fd, values.data(), values.size() * sizeof(ImageValueRecord), header.dataStackOffset) ||
+            !readAll(fd, tables.data(), tables.size() * sizeof(ImageStringRecord), header.tableStackOffset) ||
+            !readAll(fd, strings.data(), strings.size(), header.stringsOffset)) {
+            cleanup();
+            return std::nullopt;
+        }
+        auto memory = MemorySpace::map(fd, header.memoryOffset, header.memorySize, mode);
+        cleanup();
+        if (!memory) {
+            return std::nullopt;
+        }
+        auto stringAt = [&strings](std::uint64_t offset, std::uint64_t length) -> std::optional<std::string_view> {
+            if (offset > strings.size() || length > strings.size() - offset) {
+                return std::nullopt;
+            }
+            return std::string_view { strings }.substr(offset, length);
+        };
+        ImageContents result { std::move(*memory), { }, { } };
+        result.dataStack.reserve(values.size());
+        for (const auto& record : values) {
+            switch (static_cast<Value::Kind>(record.kind)) {
+                case Value::Kind::String:
+                    if (auto str = stringAt(record.payload, record.length); str) {
+                        result.dataStack.emplace_back(*str);
+                    } else {
+                        return std::nullopt;
+                    }
+                    break;
+                case Value::Kind::Integer: result.dataStack.emplace_back(static_cast<Integer>(record.payload)); break;
+                case Value::Kind::Ordinal: result.dataStack.emplace_back(static_cast<Ordinal>(record.payload)); break;
+                case Value::Kind::Character: result.dataStack.emplace_back(static_cast<Character>(record.payload)); break;
+                case Value::Kind::Boolean: result.dataStack.emplace_back(record.payload != 0); break;
+                default: result.dataStack.emplace_back(); break;
+            }
+        }
+        for (const auto& record : tables) {
+            if (auto str = stringAt(record.offset, record.length); str) {
+                result.tableStack.emplace_back(*str);
+            } else {
+                return std::nullopt;
+            }
+        }
+        return result;
+    }
+} // end namespace Deception
@@ -0,0 +1,100 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_IMAGE_H
+#define DECEPTION_IMAGE_H
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include <core/Value.h>
+#include <core/DataStack.h>
+#include <core/MemorySpace.h>
+namespace Deception {
+    /**
+     * @brief The start of a saved image. Every section is a flat array of fixed size records so loading an image is
+     * a handful of reads plus one mmap of the memory section, which starts on a page boundary. Images are written in
+     * the byte order of the machine that made them and are rejected elsewhere.
+     */
+    struct ImageHeader {
+        static constexpr std::array<char, 8> ExpectedMagic { 'D', 'E', 'C', 'E', 'P', 'T', 'I', 'M' };
+        static constexpr std::uint32_t CurrentVersion = 1;
+        static constexpr std::uint32_t ByteOrderMark = 0x0102'0304;
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        /// array of ImageValueRecord from the bottom of the data stack to the top
+        std::uint64_t dataStackOffset;
+        std::uint64_t dataStackCount;
+        /// array of ImageStringRecord naming each table from the bottom of the execution stack to the top
+        std::uint64_t tableStackOffset;
+        std::uint64_t tableStackCount;
+        /// the characters of every string referenced by the other sections
+        std::uint64_t stringsOffset;
+        std::uint64_t stringsSize;
+        /// the contents of the memory space, pages which are all zero are left as holes in the file
+        std::uint64_t memoryOffset;
+        std::uint64_t memorySize;
+    };
+    struct ImageValueRecord {
+        std::uint8_t kind;
+        std::uint8_t reserved[3];
+        /// the length of the string for string values
+        std::uint32_t length;
+        /// the value itself or the offset of the string in the strings section
+        std::uint64_t payload;
+    };
+    struct ImageStringRecord {
+        std::uint64_t offset;
+        std::uint64_t length;
+    };
+    /**
+     * @brief Everything pulled back out of an image
+     */
+    struct ImageContents {
+        MemorySpace memory;
+        std::vector<Value> dataStack;
+        std::vector<std::string> tableStack;
+    };
+    /**
+     * Write an image to disk, it is written next to the destination first and then renamed over it so a space mapped
+     * from the old image is never truncated underneath itself
+     * @param path The file to write
+     * @param memory The memory space to save, only the pages which have been touched are written
+     * @param dataStack The data stack to save
+     * @param tableStack The names of the tables on the execution stack from the bottom to the top
+     * @return false if the image could not be written
+     */
+    bool saveImage(const std::string& path, const MemorySpace& memory, const DataStack<Value>& dataStack, const std::vector<std::string>& tableStack);
+    /**
+     * Load an image back in, the memory space is mapped straight out of the file
+     * @param path The image to load
+     * @param mode Private spaces are copy on write, shared spaces write back into the image
+     * @return The contents of the image or std::nullopt if it could not be read or is not a compatible image
+     */
+    std::optional<ImageContents> loadImage(const std::string& path, MappingMode mode = MappingMode::Private);
+} // end namespace Deception
+#endif //DECEPTION_IMAGE_H
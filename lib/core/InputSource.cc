@@ -0,0 +1,157 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/InputSource.h>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+
+namespace Deception {
+    InputSource
+    InputSource::copyOf(std::string_view characters) {
+        InputSource result;
+        result._origin = Origin::Characters;
+        char* storage = result._inline.data();
+        if (characters.size() > InlineCapacity) {
+            result._buffer = std::make_unique_for_overwrite<char[]>(characters.size());
+            result._capacity = characters.size();
+            storage = result._buffer.get();
+        }
+        std::memcpy(storage, characters.data(), characters.size());
+        result._position = storage;
+        result._end = storage + characters.size();
+        return result;
+    }
+    InputSource
+    InputSource::borrow(std::string_view characters, Origin origin) noexcept {
+        InputSource result;
+        result._origin = origin;
+        result._position = characters.data();
+        result._end = characters.data() + characters.size();
+        return result;
+    }
+    void
+    InputSource::take(InputSource&& other) noexcept {
+        auto wasInline = other.isInline();
+        _stream = std::move(other._stream);
+        _origin = other._origin;
+        _blockSize = other._blockSize;
+        _capacity = other._capacity;
+        _buffer = std::move(other._buffer);
+        _mapped = other._mapped;
+        if (wasInline) {
+            // inline characters move with the source so the cursor has to follow them
+            _inline = other._inline;
+            _position = _inline.data() + (other._position - other._inline.data());
+            _end = _inline.data() + (other._end - other._inline.data());
+        } else {
+            _position = other._position;
+            _end = other._end;
+        }
+        other._position = nullptr;
+        other._end = nullptr;
+    }
+    InputSource
+    InputSource::fork() const {
+        std::string_view unread { _position, static_cast<std::size_t>(_end - _position) };
+        if (auto file = std::get_if<SharedMappedFile>(&_stream); _origin == Origin::Stream && file) {
+            // the mapping is kept alive by the shared file so the cursor can point straight into it
+            InputSource result { *file, _blockSize };
+            result._mapped = _mapped;
+            result._position = _position;
+            result._end = _end;
+            return result;
+        }
+        // an istream cannot be shared without one branch reading characters out from under another
+        return copyOf(unread);
+    }
+    void
+    InputSource::detach() {
+        if (_origin == Origin::Borrowed || _origin == Origin::Memory) {
+            *this = copyOf({ _position, static_cast<std::size_t>(_end - _position) });
+        }
+    }
+    bool
+    InputSource::valid() const noexcept {
+        if (buffered()) {
+            return true;
+        }
+        return std::visit([this](auto&& stream) -> bool {
+            using K = std::decay_t<decltype(stream)>;
+            if constexpr (std::is_same_v<K, SharedMappedFile>) {
+                return stream && !_mapped && !stream->empty();
+            } else {
+                return stream && stream->operator bool();
+            }
+        }, _stream);
+    }
+    bool
+    InputSource::refill() {
+        auto count = std::visit([this](auto&& stream) -> std::size_t { return stream ? refill(*stream) : 0; }, _stream);
+        return count > 0;
+    }
+    std::size_t
+    InputSource::refill(const MappedFile& file) noexcept {
+        // the whole file is handed over at once so there is never anything left to refill with
+        if (_mapped) {
+            _position = _end;
+            return 0;
+        }
+        _mapped = true;
+        _position = file.begin();
+        _end = file.end();
+        return file.size();
+    }
+    std::size_t
+    InputSource::refill(std::istream& stream) {
+        std::size_t total = 0;
+        if (stream) {
+            // size the buffer off of what the stream says it has ready so that short lived streams (a single pushed
+            // back character for instance) do not pay for a full block
+            auto available = stream.rdbuf()->in_avail();
+            auto wanted = std::clamp<std::size_t>(available > 0 ? static_cast<std::size_t>(available) + 1 : 1, 1, _blockSize);
+            if (wanted > _capacity) {
+                _buffer = std::make_unique_for_overwrite<char[]>(wanted);
+                _capacity = wanted;
+            }
+            // block on the first character so interactive streams keep working, then take whatever else the stream
+            // already has available without blocking again
+            if (auto first = stream.get(); first != std::istream::traits_type::eof()) {
+                _buffer[0] = static_cast<char>(first);
+                total = 1;
+                while (total < _capacity) {
+                    if (auto amount = stream.readsome(_buffer.get() + total, static_cast<std::streamsize>(_capacity - total)); amount > 0) {
+                        total += static_cast<std::size_t>(amount);
+                    } else {
+                        break;
+                    }
+                }
+            }
+        }
+        _position = _buffer.get();
+        _end = _position + total;
+        return total;
+    }
+} // end namespace Deception
@@ -0,0 +1,154 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_INPUTSOURCE_H
+#define DECEPTION_INPUTSOURCE_H
+#include <array>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <core/Value.h>
+#include <core/MappedFile.h>
+#include <core/Scan.h>
+namespace Deception {
+    /**
+     * @brief Wraps an InputStream and pulls large blocks out of it. The interpreter reads characters out of a
+     * contiguous buffer and only goes back to the underlying stream once that buffer has been drained. Mapped files
+     * skip the buffer entirely and are read straight out of the mapping.
+     *
+     * Sources can also be made directly out of characters, these have no stream behind them and are exhausted once
+     * their characters have been read. Short runs of characters are kept inside of the source itself so pushing them
+     * does not allocate.
+     */
+    class InputSource {
+    public:
+        static constexpr std::size_t DefaultBlockSize = 64 * 1024;
+        static constexpr std::size_t InlineCapacity = 16;
+        enum class Origin {
+            /// reads blocks out of an InputStream
+            Stream,
+            /// owns a copy of its characters, inline when they fit
+            Characters,
+            /// reads characters owned by someone else
+            Borrowed,
+            /// reads characters out of a MemorySpace
+            Memory,
+        };
+        explicit InputSource(InputStream stream, std::size_t blockSize = DefaultBlockSize) : _stream(std::move(stream)), _blockSize(blockSize == 0 ? 1 : blockSize) { }
+        /**
+         * Make a source out of a copy of the given characters, nothing is allocated if they fit in InlineCapacity
+         */
+        static InputSource copyOf(std::string_view characters);
+        /**
+         * Make a source which reads the given characters in place, they must outlive the source
+         */
+        static InputSource borrow(std::string_view characters, Origin origin = Origin::Borrowed) noexcept;
+        InputSource(const InputSource&) = delete;
+        InputSource(InputSource&& other) noexcept { take(std::move(other)); }
+        InputSource& operator=(const InputSource&) = delete;
+        InputSource& operator=(InputSource&& other) noexcept {
+            if (this != &other) {
+                take(std::move(other));
+            }
+            return *this;
+        }
+        /**
+         * Get the next character out of the buffer, going back to the stream when the buffer is empty
+         * @return The next character or std::nullopt if the underlying stream has been exhausted
+         */
+        StreamReadResult next() {
+            if (_position == _end && !refill()) {
+                return std::nullopt;
+            }
+            return *_position++;
+        }
+        /**
+         * Take every buffered character up to (but not including) the first one found in the given set. The stream is
+         * never touched so this returns an empty view once the buffer has been drained.
+         * @return A view into the buffer which stays valid until the next refill
+         */
+        std::string_view takeUntil(std::string_view terminators) noexcept {
+            auto stop = findFirstOf(_position, _end, terminators);
+            std::string_view result { _position, static_cast<std::size_t>(stop - _position) };
+            _position = stop;
+            return result;
+        }
+        /**
+         * Pull the next block of characters out of the underlying stream, any unread characters are discarded
+         * @return true if at least one character is now available
+         */
+        bool refill();
+        /**
+         * @return true if there are characters in the buffer that have not been consumed yet
+         */
+        [[nodiscard]] bool buffered() const noexcept { return _position != _end; }
+        /**
+         * Look at the next buffered character without consuming it, only valid when buffered() is true
+         */
+        [[nodiscard]] char peek() const noexcept { return *_position; }
+        /**
+         * Consume the character peek returned
+         */
+        void skip() noexcept { ++_position; }
+        /**
+         * @return true if there are buffered characters or the underlying stream has not reported a failure yet
+         */
+        [[nodiscard]] bool valid() const noexcept;
+        [[nodiscard]] InputStream& stream() noexcept { return _stream; }
+        [[nodiscard]] const InputStream& stream() const noexcept { return _stream; }
+        [[nodiscard]] constexpr Origin origin() const noexcept { return _origin; }
+        /**
+         * Make an independent source which reads the same characters as this one from the current position. Mapped
+         * files are shared as is since nothing can change them. Everything else becomes a copy of the unread
+         * characters, for an istream that is only what has been buffered so far: the stream itself stays with this
+         * source and is never read by the copy. Borrowed and memory backed characters are copied since the new source
+         * may outlive what they borrow from.
+         */
+        [[nodiscard]] InputSource fork() const;
+        /**
+         * Copy the unread characters of a borrowed source into a buffer owned by the source so it no longer depends
+         * on whatever it was borrowing from
+         */
+        void detach();
+    private:
+        InputSource() = default;
+        void take(InputSource&& other) noexcept;
+        [[nodiscard]] bool isInline() const noexcept { return _origin == Origin::Characters && !_buffer; }
+        std::size_t refill(std::istream& stream);
+        std::size_t refill(const MappedFile& file) noexcept;
+    private:
+        InputStream _stream { ObservedInputStream { nullptr } };
+        Origin _origin = Origin::Stream;
+        std::size_t _blockSize = DefaultBlockSize;
+        std::size_t _capacity = 0;
+        std::unique_ptr<char[]> _buffer;
+        const char* _position = nullptr;
+        const char* _end = nullptr;
+        bool _mapped = false;
+        std::array<char, InlineCapacity> _inline;
+    };
+    using InputSourceStack = std::vector<InputSource>;
+} // end namespace Deception
+#endif //DECEPTION_INPUTSOURCE_H
@@ -23,43 +23,288 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include <core/Interpreter.h>
+#include <core/Disassembler.h>
 #include <iostream>
 namespace Deception {
-    Interpreter::Interpreter(std::initializer_list<Conclave::InputEntry> tables, std::initializer_list<StreamType> streamStack, Address capacity) : _tables(tables), _inputStreams(streamStack), _memory(capacity) { }
+    Interpreter::Interpreter(std::initializer_list<Conclave::InputEntry> tables, std::initializer_list<StreamType> streamStack, Address capacity) : Interpreter(snapshot(tables), streamStack, capacity) { }
     Interpreter::Interpreter(std::initializer_list<Conclave::InputEntry> tables, Address capacity) : Interpreter(tables, {std::experimental::make_observer<std::istream>(&std::cin)}, capacity) { }
+    Interpreter::Interpreter(SharedConclave tables, std::initializer_list<StreamType> streamStack, Address capacity) : _tables(std::move(tables)), _inputStreams(streamStack.begin(), streamStack.end()), _memory(capacity) { }
+    Interpreter::Interpreter(const Checkpoint& from) :
+            _dataStack(from.dataStack),
+            _executionStack(from.executionStack),
+            _tables(from.tables),
+            _executing(from.executing),
+            _output(from.output),
+            _memory(from.memory.map()),
+            _pending(from.pending),
+            _inputClosed(from.inputClosed),
+            _trace(from.trace),
+            _counters(from.counters) {
+        _fusedPairs = from.fusedPairs;
+        _pairing = !_fusedPairs.empty();
+        _inputStreams.reserve(from.inputStreams.size());
+        for (const auto& source : from.inputStreams) {
+            _inputStreams.push_back(source.fork());
+        }
+        refreshCurrent();
+    }
+    Interpreter::Checkpoint::Checkpoint(const Interpreter& source) :
+            tables(source._tables),
+            memory(source._memory),
+            dataStack(source._dataStack),
+            executionStack(source._executionStack),
+            output(source.getOutput()),
+            pending(source._pending),
+            executing(source._executing),
+            inputClosed(source._inputClosed),
+            trace(source._trace),
+            counters(source._counters),
+            fusedPairs(source._fusedPairs) {
+        inputStreams.reserve(source._inputStreams.size());
+        for (const auto& stream : source._inputStreams) {
+            inputStreams.push_back(stream.fork());
+        }
+    }
+    std::shared_ptr<const Interpreter::Checkpoint>
+    Interpreter::checkpoint() {
+        auto result = std::make_shared<const Checkpoint>(*this);
+        // the conclave is shared with the checkpoint now so it has to be copied again before it is changed
+        _ownedTables.reset();
+        return result;
+    }
+
+    Interpreter::Conclave&
+    Interpreter::ownTables() {
+        if (!_ownedTables) {
+            _ownedTables = std::make_shared<Conclave>(*_tables);
+            _tables = _ownedTables;
+        }
+        return *_ownedTables;
+    }
 
     void
-    Interpreter::use(const std::string& name) {
-        use(_tables.find(name));
+    Interpreter::use(std::string_view name) {
+        use(_tables->handleOf(name));
     }
     void
     Interpreter::use(TableReference ptr) {
-        if (getCurrentTable()) {
-            getCurrentTable()->leaveTable(*this);
+        if (auto handle = _tables->handleOf(ptr); handle != InvalidTableHandle) {
+            use(handle);
+        } else {
+            use(ownTables().adopt(ptr));
         }
-        if (ptr) {
-            _executionStack.push(ptr);
-            getCurrentTable()->enterTable(*this);
+    }
+    void
+    Interpreter::use(TableHandle handle) {
+        if (_current) {
+            _current->leaveTable(*this);
+            _counters.left(_executionStack.back());
+        }
+        if (_tables->contains(handle)) {
+            _executionStack.push_back(handle);
+            refreshCurrent();
+            _current->enterTable(*this);
+            _counters.entered(handle);
         }
     }
     void
     Interpreter::restore() {
         if (!_executionStack.empty()) {
-            getCurrentTable()->leaveTable(*this);
-            _executionStack.pop();
+            _current->leaveTable(*this);
+            _counters.left(_executionStack.back());
+            _executionStack.pop_back();
+            refreshCurrent();
         }
     }
+    Interpreter::RunState
+    Interpreter::runAvailable() {
+        _stepping = true;
+        // without a current table there is nothing to dispatch to
+        while (_executing && _current) {
+            if (!_currentTerminators.empty() && consumeSpan()) {
+                continue;
+            }
+            if (auto current = next(); current) {
+                dispatch(*current);
+            } else {
+                break;
+            }
+        }
+        _stepping = false;
+        _sink->flush();
+        return _executing && _current ? RunState::NeedsInput : RunState::Terminated;
+    }
+    void
+    Interpreter::refreshCurrent() noexcept {
+        _current = _executionStack.empty() ? nullptr : _tables->get(_executionStack.back());
+        _currentTerminators = _current ? _current->terminators() : std::string_view { };
+    }
     void
     Interpreter::run() {
         do {
+            if (!_current) {
+                // there is nothing to dispatch to until a table has been used
+                break;
+            }
+            if (!_currentTerminators.empty() && consumeSpan()) {
+                continue;
+            }
             if (auto current = next(); stopProcessing() || !current) {
                 break;
             } else {
-                // keep track of our execution chain in case we want to display it back
-                _previousExecution.put(*current);
-                (*getCurrentTable())(*current, *this);
+                dispatch(*current);
             }
         } while (true);
+        _sink->flush();
+    }
+    bool
+    Interpreter::consumeSpan() {
+        if (_inputStreams.empty()) {
+            return false;
+        }
+        // only what is already buffered is scanned, next() takes care of refilling and of exhausted streams
+        auto span = _inputStreams.back().takeUntil(_currentTerminators);
+        if (span.empty()) {
+            return false;
+        }
+        _trace.record(_executionStack.back(), span);
+        // whatever comes after the span was not dispatched right after the last character
+        _lastTable = InvalidTableHandle;
+        _counters.consumed(_executionStack.back(), span);
+        _current->consumeSpan(*this, span);
+        return true;
+    }
+    void
+    Interpreter::dispatch(char c) {
+        // keep track of our execution chain in case we want to display it back
+        _trace.record(_executionStack.back(), c);
+        if constexpr (Counters::enabled) {
+            // the extra resolve is only paid for when counting
+            _counters.dispatched(_executionStack.back(), c);
+            if (!_current->hasEntry(c)) {
+                _counters.fellBack(_executionStack.back());
+            }
+        }
+        if (_pairing) {
+            dispatchPair(c);
+        } else {
+            _current->run(c, *this);
+        }
+    }
+    void
+    Interpreter::dispatchPair(char c) {
+        auto table = _executionStack.back();
+        if (_profilingPairs) {
+            if (_lastEpoch == _inputEpoch && _lastTable != InvalidTableHandle) {
+                _pairProfile.record(_lastTable, _lastCharacter, c);
+            }
+            _lastTable = table;
+            _lastCharacter = c;
+            _lastEpoch = _inputEpoch;
+        }
+        auto* fused = _fusedPairs.find(table, c);
+        if (!fused) {
+            _current->run(c, *this);
+            return;
+        }
+        auto epoch = _inputEpoch;
+        fused->first.refresh(_current, c);
+        if (fused->first.body) {
+            (*fused->first.body)(*this, c);
+        } else {
+            _current->defaultImplementation(*this, c);
+        }
+        // the run loop would dispatch the next buffered character of the same source next, unless the current
+        // table consumes spans or there is nothing left to do
+        if (!_executing || epoch != _inputEpoch || !_current || !_currentTerminators.empty()) {
+            return;
+        }
+        auto& source = _inputStreams.back();
+        if (!source.buffered()) {
+            return;
+        }
+        auto next = source.peek();
+        auto* second = fused->find(next);
+        if (!second) {
+            return;
+        }
+        source.skip();
+        table = _executionStack.back();
+        _trace.record(table, next);
+        second->refresh(_current, next);
+        _counters.dispatched(table, next);
+        if (_profilingPairs) {
+            _pairProfile.record(_lastTable, _lastCharacter, next);
+            _lastTable = table;
+            _lastCharacter = next;
+        }
+        if (second->body) {
+            (*second->body)(*this, next);
+        } else {
+            _counters.fellBack(table);
+            _current->defaultImplementation(*this, next);
+        }
+    }
+    void
+    Interpreter::profilePairs(bool enable) noexcept {
+        _profilingPairs = enable;
+        _lastTable = InvalidTableHandle;
+        _pairing = _profilingPairs || !_fusedPairs.empty();
+    }
+    std::size_t
+    Interpreter::fuse(const PairProfile& profile, std::size_t limit, PairProfile::Count minimum) {
+        std::size_t count = 0;
+        for (const auto& pair : profile.hottest(limit, minimum)) {
+            // a profile from a different conclave may name tables this one does not have
+            if (pair.table < _tables->handleCount()) {
+                _fusedPairs.add(pair.table, pair.first, pair.second);
+                ++count;
+            }
+        }
+        _pairing = _profilingPairs || !_fusedPairs.empty();
+        return count;
+    }
+    void
+    Interpreter::unfuse() noexcept {
+        _fusedPairs.clear();
+        _pairing = _profilingPairs;
+    }
+    void
+    Interpreter::drainInputAbove(std::size_t depth) {
+        while (_executing && _current && _inputStreams.size() > depth) {
+            if (!_inputStreams.back().buffered()) {
+                pinOutput();
+            }
+            if (auto current = _inputStreams.back().next(); current) {
+                dispatch(*current);
+            } else {
+                restoreInputStream();
+            }
+        }
+    }
+    void
+    Interpreter::execute(Routine& routine) {
+        auto depth = _inputStreams.size();
+        for (std::size_t i = 0; i < routine.size() && _executing; ++i) {
+            auto* table = currentTable();
+            if (!table) {
+                break;
+            }
+            auto c = routine.character(i);
+            const auto& step = routine.step(i, table);
+            _trace.record(_executionStack.back(), c);
+            _counters.dispatched(_executionStack.back(), c);
+            if (step.body) {
+                (*step.body)(*this, c);
+            } else {
+                _counters.fellBack(_executionStack.back());
+                table->defaultImplementation(*this, c);
+            }
+            if (_inputStreams.size() > depth) {
+                // the action pushed more input, that has to be consumed before the rest of the routine
+                drainInputAbove(depth);
+            }
+        }
     }
 
     void
@@ -72,9 +317,7 @@ namespace Deception {
         if (_dataStack.empty())  {
             return std::nullopt;
         } else {
-            Value result = _dataStack.back();
-            _dataStack.pop_back();
-            return result;
+            return _dataStack.pop();
         }
     }
     bool
@@ -82,52 +325,103 @@ namespace Deception {
 
     bool
     Interpreter::currentStreamValid() const noexcept {
-        return !_inputStreams.empty() && std::visit([](auto&& stream) { return stream->operator bool(); }, getCurrentStream());
+        return !_inputStreams.empty() && _inputStreams.back().valid();
     }
     const Interpreter::StreamType&
     Interpreter::getCurrentStream() const noexcept {
-        return _inputStreams.back();
+        return _inputStreams.back().stream();
     }
     Interpreter::StreamType&
     Interpreter::getCurrentStream() noexcept {
-        return _inputStreams.back();
+        return _inputStreams.back().stream();
     }
     Interpreter::StreamResult
     Interpreter::next() {
-        if (!currentStreamValid()) {
-            // see if we can go to the next entry in the stream set
+        while (!_inputStreams.empty() || !_pending.empty()) {
             if (_inputStreams.empty()) {
-                // we have nothing left to process so just mark the interpreter as done and terminate, return the termination character as well
-                terminate();
-                return std::nullopt;
+                // the previous feed has been popped off the stack so its buffer can be reused
+                _feeding->swap(_pending);
+                _pending.clear();
+                borrowInputStream(*_feeding);
             }
-            // we are done so go back to the previous one
+            auto& source = _inputStreams.back();
+            // the common case is a character sitting in the current block so nothing else is touched
+            if (source.buffered()) {
+                return source.next();
+            }
+            // the block is about to be replaced so anything borrowed from it has to be copied out first
+            pinOutput();
+            if (source.origin() == InputSource::Origin::Stream) {
+                // reading the next block can block, whoever is waiting on the other end should see our output first
+                _sink->flush();
+            }
+            if (auto result = source.next(); result) {
+                return result;
+            }
+            // this stream is exhausted so go back to the previous one
             restoreInputStream();
         }
-        return std::visit([](auto&& stream) -> char { return static_cast<char>(stream->get()); }, getCurrentStream());
+        // we have nothing left to process so just mark the interpreter as done, unless more is going to be fed
+        if (!_stepping || _inputClosed) {
+            terminate();
+        }
+        return std::nullopt;
     }
 
     bool
     Interpreter::stopProcessing() const noexcept {
-        return !_executing || _inputStreams.empty() || !currentStreamValid();
+        // next() discards exhausted streams so there is no need to check the current stream again here
+        return !_executing || _inputStreams.empty();
     }
     void
     Interpreter::restoreInputStream() {
+        pinOutput();
         _inputStreams.pop_back();
+        ++_inputEpoch;
+        _counters.streamPopped();
+    }
+    void
+    Interpreter::pushInput(InputSource&& source) {
+        // growing the stack moves inline characters, anything borrowed from them has to be copied out first
+        pinOutput();
+        _inputStreams.push_back(std::move(source));
+        ++_inputEpoch;
+        _counters.streamPushed();
     }
     void
     Interpreter::useInputStream(const std::string& stream) {
-        useInputStream(std::make_shared<std::stringstream>(stream));
+        pushInput(InputSource::copyOf(stream));
+    }
+    void
+    Interpreter::borrowInputStream(std::string_view characters) {
+        pushInput(InputSource::borrow(characters));
+    }
+    bool
+    Interpreter::useMemoryAsInput(Address start, Address length) {
+        if (start > _memory.size() || length > _memory.size() - start) {
+            return false;
+        }
+        pushInput(InputSource::borrow({ _memory.data() + start, length }, InputSource::Origin::Memory));
+        return true;
+    }
+    bool
+    Interpreter::useInputFile(const std::string& path) {
+        if (auto file = MappedFile::open(path); file) {
+            useInputStream(file);
+            return true;
+        } else {
+            return false;
+        }
     }
     void
     Interpreter::useInputStream(char c) {
-        useInputStream(std::string(1, c));
+        pushInput(InputSource::copyOf({ &c, 1 }));
     }
     void
     Interpreter::useFromStack() {
         if (auto top = popElement(); top) {
-            if (std::holds_alternative<std::string>(*top)) {
-                use(std::get<std::string>(*top));
+            if (top.isString()) {
+                use(top.asString());
                 return;
             } else {
                 std::cerr << "useFromStack: Top element not a string!" << std::endl;
@@ -137,30 +431,103 @@ namespace Deception {
         }
         //  report an error
     }
+    bool
+    Interpreter::saveImage(const std::string& path) const {
+        std::vector<std::string> tables;
+        tables.reserve(_executionStack.size());
+        for (auto handle : _executionStack) {
+            if (auto name = _tables->nameOf(handle); name) {
+                tables.push_back(*name);
+            } else {
+                return false;
+            }
+        }
+        return Deception::saveImage(path, _memory, _dataStack, tables);
+    }
+    bool
+    Interpreter::loadImage(const std::string& path, MappingMode mode) {
+        auto contents = Deception::loadImage(path, mode);
+        if (!contents) {
+            return false;
+        }
+        ExecutionStack tables;
+        tables.reserve(contents->tableStack.size());
+        for (const auto& name : contents->tableStack) {
+            if (auto handle = _tables->handleOf(name); _tables->contains(handle)) {
+                tables.push_back(handle);
+            } else {
+                return false;
+            }
+        }
+        _executionStack = std::move(tables);
+        refreshCurrent();
+        _dataStack.clear();
+        for (const auto& value : contents->dataStack) {
+            _dataStack.push(value);
+        }
+        // sources reading out of the old memory space would be left dangling, and so would a string borrowed from one
+        pinOutput();
+        for (auto& source : _inputStreams) {
+            if (source.origin() == InputSource::Origin::Memory) {
+                source.detach();
+            }
+        }
+        _memory = std::move(contents->memory);
+        return true;
+    }
+    void
+    Interpreter::disassembleTrace(std::ostream& out) const {
+        std::vector<std::string> names(_tables->handleCount());
+        for (TableHandle i = 0; i < names.size(); ++i) {
+            names[i] = _tables->nameOf(i).value_or("table " + std::to_string(i));
+        }
+        TraceDisassembler disassembler { out };
+        _trace.forEach([&names, &disassembler](const Trace::Event& event) {
+            disassembler.write(event.table < names.size() ? std::string_view { names[event.table] } : std::string_view { "?" }, event.character);
+        });
+    }
+    void
+    Interpreter::writeCounters(std::ostream& out) const {
+        std::vector<std::optional<std::string>> names(_tables->handleCount());
+        for (TableHandle i = 0; i < names.size(); ++i) {
+            names[i] = _tables->nameOf(i);
+        }
+        _counters.writeJson(out, names);
+    }
+    void
+    Interpreter::setOutputSink(std::unique_ptr<OutputSink> sink) {
+        _sink->flush();
+        _sink = std::move(sink);
+    }
     void
     displayCurrentTableContents(Deception::Interpreter& interpreter, char) {
         auto theTable = interpreter.getCurrentTable();
         for (int i = 0; i < 0x100; ++i) {
             char c = static_cast<char>(i);
-            if (auto result = theTable->lookup(c); result) {
-                std::cout << c << std::endl;
+            if (theTable->hasEntry(c)) {
+                interpreter.out() << c << '\n';
             }
         }
     }
     void
     displayTopItemOnDataStack(Deception::Interpreter& interpreter, char) {
         if (interpreter.dataStackEmpty())  {
-            std::cout << "data stack empty!" << std::endl;
+            interpreter.out() << "data stack empty!\n";
         } else {
-            std::cout << "top of stack" << std::endl;
+            interpreter.out() << "top of stack\n";
             for (auto i = interpreter.dataStackReverseBegin(); i != interpreter.dataStackReverseEnd(); ++i) {
                 if (auto internalValue = *i; internalValue) {
-                    std::visit([](auto&& value) { std::cout << "- " << value << std::endl; }, *internalValue);
+                    std::visit([&interpreter](auto&& value) { interpreter.out() << "- " << value << '\n'; }, *internalValue);
                 } else {
-                    std::cout << "- null" << std::endl;
+                    interpreter.out() << "- null\n";
                 }
             }
-            std::cout << "bottom of stack" << std::endl;
+            interpreter.out() << "bottom of stack\n";
         }
     }
+    void
+    displayCounters(Deception::Interpreter& interpreter, char) {
+        interpreter.writeCounters(interpreter.out());
+        interpreter.out() << '\n';
+    }
 } // end namespace Deception
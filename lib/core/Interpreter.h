@@ -30,44 +30,141 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DECEPTION_INTERPRETER_H
 #include <istream>
 #include <sstream>
-#include <list>
 #include <memory>
+#include <unistd.h>
 #include <experimental/memory>
 #include <core/Value.h>
+#include <core/DataStack.h>
+#include <core/InputSource.h>
 #include <core/Table.h>
 #include <core/Conclave.h>
+#include <core/ExecutionTrace.h>
+#include <core/Counters.h>
+#include <core/ThreadedCode.h>
 #include <core/MemorySpace.h>
+#include <core/Image.h>
+#include <core/OutputSink.h>
+#include <core/Superinstructions.h>
 namespace Deception {
     class Interpreter {
     public:
         using Conclave = Deception::Conclave<Interpreter>;
         using Table = Deception::Table<Interpreter>;
+        using DenseTable = Deception::DenseTable<Interpreter>;
+        template<typename ... Entries>
+        using StaticTable = Deception::StaticTable<Interpreter, Entries...>;
         using TableReference = Conclave::GenericTableReference;
         using ListEntry = typename Conclave::InputEntry;
-        using DataStack = std::list<Value>;
-        using ExecutionStack = std::stack<TableReference>;
+        using DataStack = Deception::DataStack<Value>;
+        using ExecutionStack = std::vector<TableHandle>;
         using StreamType = InputStream;
-        using StreamStack = InputStreamStack;
+        using StreamStack = InputSourceStack;
         using StreamResult = StreamReadResult;
+        using Trace = ExecutionTrace<TableHandle>;
+        using Routine = ThreadedRoutine<Interpreter>;
+        using Counters = Deception::Counters;
+        /**
+         * Why runAvailable returned
+         */
+        enum class RunState {
+            /// everything fed so far has been consumed, feed more and call runAvailable again
+            NeedsInput,
+            /// the interpreter was terminated, its input was closed and has been consumed or no table is in use
+            Terminated,
+        };
+        /**
+         * A conclave which can be handed to many interpreters at once, possibly on different threads. Interpreters
+         * only read through it and take a private copy of it the first time they need to register a table of their
+         * own. The tables themselves are shared as well so they must not be modified while other interpreters are
+         * using them.
+         */
+        using SharedConclave = std::shared_ptr<const Conclave>;
+        struct Checkpoint;
         Interpreter(std::initializer_list<ListEntry> tables, std::initializer_list<StreamType> startingStreamEntries, Address capacity = (256 * 1024 * 1024));
         Interpreter(std::initializer_list<ListEntry> tables, Address capacity = (256*1024*1024));
-        void use(const std::string& name);
+        Interpreter(SharedConclave tables, std::initializer_list<StreamType> startingStreamEntries, Address capacity = (256 * 1024 * 1024));
+        /**
+         * Start a new branch from a checkpoint, the memory space is mapped copy on write from the checkpoint so this
+         * does not depend on the size of the memory space. The data and execution stacks are copied, which costs one
+         * step per element since long strings on the data stack are shared and not copied.
+         * @throws std::system_error if the memory space cannot be mapped
+         */
+        explicit Interpreter(const Checkpoint& from);
+        /**
+         * Capture the state of this interpreter so that any number of branches can be started from it. The touched
+         * pages of the memory space are copied once, the stacks and pending input are copied as they are.
+         * Interpreters started from the checkpoint share the conclave and mapped input files. They do not share
+         * istreams: a branch only gets the characters this interpreter had buffered from one when the checkpoint was
+         * taken, the rest of the stream is left for this interpreter.
+         * @throws std::system_error if the memory space cannot be captured
+         */
+        [[nodiscard]] std::shared_ptr<const Checkpoint> checkpoint();
+        /**
+         * Build a conclave once so it can be shared between interpreters
+         */
+        static SharedConclave snapshot(std::initializer_list<ListEntry> tables) { return std::make_shared<const Conclave>(tables); }
+        void use(std::string_view name);
         void use(TableReference ptr);
+        /**
+         * Switch to a table by handle, this is the fast path since there is no name lookup involved
+         */
+        void use(TableHandle handle);
+        [[nodiscard]] TableHandle handleOf(std::string_view name) const noexcept { return _tables->handleOf(name); }
         void useFromStack();
         void restore();
+        /**
+         * Dispatch input until the interpreter terminates or the input is exhausted, nothing is dispatched while no
+         * table is in use
+         */
         void run();
+        /**
+         * Run until the input runs dry without blocking or terminating, this lets one thread drive many interpreters
+         * by feeding each one whatever bytes have arrived for it. Only sources which never block (fed bytes,
+         * characters, memory and mapped files) should be on the input stack while stepping. When nothing is left an
+         * action pulling characters through next() gets std::nullopt, the same as at the end of the input. Nothing is
+         * dispatched while no table is in use, Terminated is returned instead.
+         */
+        RunState runAvailable();
+        /**
+         * Queue bytes to be read once everything on the input stack has been consumed, fed bytes are read in the order
+         * they were fed
+         */
+        void feed(std::string_view bytes) { _pending.append(bytes); }
+        /**
+         * No more bytes will be fed, the interpreter terminates once what has been fed is consumed
+         */
+        void closeInput() noexcept { _inputClosed = true; }
+        [[nodiscard]] bool inputClosed() const noexcept { return _inputClosed; }
+        /**
+         * Run a compiled routine, this behaves the same as pushing its code as an input stream and running until
+         * those characters have been consumed but skips the stream and, once compiled, the table lookups. Anything an
+         * action pushes onto the input stack while the routine runs is consumed before the routine continues. Actions
+         * which pull characters themselves through next() read from the input stack and not from the routine.
+         * The caller owns the routine, keep it around for as long as the code is going to be run again.
+         */
+        void execute(Routine& routine);
         StreamResult next();
         bool stopProcessing() const noexcept;
-        [[nodiscard]] TableReference getCurrentTable() noexcept { return _executionStack.empty() ? nullptr : _executionStack.top(); }
-        auto operator[](const Conclave::BackingStore::key_type& index) noexcept { return _tables[index]; }
-        auto operator[](Conclave::BackingStore::key_type&& index) noexcept { return _tables[index]; }
+        [[nodiscard]] TableReference getCurrentTable() noexcept { return _executionStack.empty() ? nullptr : _tables->reference(_executionStack.back()); }
+        [[nodiscard]] TableHandle getCurrentHandle() const noexcept { return _executionStack.empty() ? InvalidTableHandle : _executionStack.back(); }
+        [[nodiscard]] const Conclave& getConclave() const noexcept { return *_tables; }
+        [[nodiscard]] const SharedConclave& getSharedConclave() const noexcept { return _tables; }
+        auto operator[](const Conclave::BackingStore::key_type& index) { return ownTables()[index]; }
+        auto operator[](Conclave::BackingStore::key_type&& index) { return ownTables()[index]; }
         void terminate() noexcept;
         Value popElement() noexcept;
         [[nodiscard]] bool dataStackEmpty() const noexcept;
         template<typename T>
         void pushElement(T value) noexcept {
-            _dataStack.push_back(value);
+            _dataStack.emplace(std::move(value));
+            _counters.dataStackDepth(_dataStack.size());
         }
+        [[nodiscard]] DataStack& getDataStack() noexcept { return _dataStack; }
+        [[nodiscard]] const DataStack& getDataStack() const noexcept { return _dataStack; }
+        /**
+         * Make sure the data stack can hold the given number of elements without allocating
+         */
+        void reserveDataStack(std::size_t capacity) { _dataStack.reserve(capacity); }
         auto dataStackBegin() const noexcept { return _dataStack.cbegin(); }
         auto dataStackEnd() const noexcept { return _dataStack.cend(); }
         auto dataStackReverseBegin() const noexcept { return _dataStack.crbegin(); }
@@ -78,43 +175,248 @@ namespace Deception {
         const StreamType& getCurrentStream() const noexcept;
         template<typename T>
         void useInputStream(T stream) {
-            _inputStreams.emplace_back(stream);
+            pushInput(InputSource { std::move(stream) });
         }
+        /**
+         * Push a copy of the given characters, short strings are kept inline in the input stack and do not allocate
+         */
         void useInputStream(const std::string& stream);
+        /**
+         * Map the given file into memory and read from it directly, nothing is copied through stream buffers
+         * @param path The file to read from
+         * @return false if the file could not be opened or mapped
+         */
+        bool useInputFile(const std::string& path);
         void useInputStream(char c);
+        /**
+         * Push characters which are read in place, they must stay alive until they have been consumed
+         */
+        void borrowInputStream(std::string_view characters);
+        /**
+         * Read characters straight out of the memory space, nothing is copied. The range is read as it is when each
+         * character is consumed so writes to it which happen first are seen.
+         * @return false if the range does not fit inside of the memory space
+         */
+        bool useMemoryAsInput(Address start, Address length);
         void restoreInputStream();
-        void clearOutputStream() {
-            _currentOutputStream.str("");
+        /**
+         * Empty the output buffer, the memory behind it is kept around for the next string
+         */
+        void clearOutputStream() noexcept {
+            _output.clear();
+            _borrowedOutput = { };
         }
-        void putIntoOutputStream(const std::string& str) {
-            _currentOutputStream << str;
+        void putIntoOutputStream(std::string_view str) {
+            pinOutput();
+            _output.append(str);
         }
         void putIntoOutputStream(char c) {
-            _currentOutputStream.put(c);
+            pinOutput();
+            _output.push_back(c);
+        }
+        /**
+         * Append characters which are sitting in the buffer of the current input source, as handed to
+         * GenericTable::consumeSpan. As long as nothing else has been written the output just points at the input
+         * and the characters are only copied if the input buffer is about to be refilled or discarded.
+         */
+        void borrowIntoOutputStream(std::string_view span) {
+            if (_output.empty() && (_borrowedOutput.empty() || _borrowedOutput.data() + _borrowedOutput.size() == span.data())) {
+                _borrowedOutput = { _borrowedOutput.empty() ? span.data() : _borrowedOutput.data(), _borrowedOutput.size() + span.size() };
+            } else {
+                putIntoOutputStream(span);
+            }
         }
+        /**
+         * @return The current contents of the output buffer, only valid until the output or the input changes
+         */
+        [[nodiscard]] std::string_view getOutput() const noexcept { return _borrowedOutput.empty() ? std::string_view { _output } : _borrowedOutput; }
+        /**
+         * Push the contents of the output buffer onto the data stack, this goes straight from the buffer (or the input
+         * it borrows from) into the value without any intermediate strings
+         */
         void moveOutputToStack() {
-            std::string tmp = _currentOutputStream.str();
-            pushElement(tmp);
+            pushElement(getOutput());
         }
         constexpr auto memoryCapacity() const noexcept { return _memory.size(); }
+        [[nodiscard]] MemorySpace& getMemory() noexcept { return _memory; }
+        [[nodiscard]] const MemorySpace& getMemory() const noexcept { return _memory; }
+        /**
+         * Save the memory space, the data stack and the execution stack (by table name) to an image file
+         * @return false if a table on the execution stack is not part of the conclave or the file could not be written
+         */
+        bool saveImage(const std::string& path) const;
+        /**
+         * Replace the memory space, data stack and execution stack with the contents of an image. The memory space is
+         * mapped from the file so only the pages which are touched get read. Tables are put back on the execution
+         * stack directly, their enter hooks are not run again. Nothing is changed if the image cannot be loaded.
+         * @param path The image to load
+         * @param mode Private keeps changes to memory out of the image, shared writes them back into it
+         * @return false if the image could not be loaded or names a table this interpreter does not have
+         */
+        bool loadImage(const std::string& path, MappingMode mode = MappingMode::Private);
         /**
-         * Return the list of all the opcodes previously executed minus the context of the tables used for execution (although it should not be that much of a problem overall to track!)
+         * Return the opcodes previously executed which are still retained by the trace (see setTraceMode), this is
+         * the whole history in full mode, the most recent characters in ring mode and empty when tracing is off
          * @return The sequence of operations executed in a single string (probably don't want to print this one!)
          */
-        std::string getPreviousExecution() const noexcept { return _previousExecution.str(); }
+        std::string getPreviousExecution() const { return _trace.characters(); }
+        /**
+         * Change how much execution history is kept, this discards everything recorded so far. Interpreters start out
+         * keeping all of it, long running ones should switch to a ring or turn tracing off.
+         * @param mode Off, a ring buffer of the last capacity events, or a full capture
+         * @param capacity The number of events kept in ring mode
+         */
+        void setTraceMode(TraceMode mode, std::size_t capacity = Trace::DefaultCapacity) { _trace.configure(mode, capacity); }
+        [[nodiscard]] const Trace& getTrace() const noexcept { return _trace; }
+        /**
+         * Write the retained trace out one event per line as the table name followed by the mnemonic of the character
+         */
+        void disassembleTrace(std::ostream& out) const;
+        /**
+         * The dispatch counters, these are only collected when built with DECEPTION_ENABLE_COUNTERS and read as zero
+         * otherwise
+         */
+        [[nodiscard]] const Counters& getCounters() const noexcept { return _counters; }
+        void resetCounters() noexcept { _counters.reset(); }
+        /**
+         * Write the dispatch counters out as JSON with tables named from the conclave
+         */
+        void writeCounters(std::ostream& out) const;
+        /**
+         * Where built in actions write their output. It is block buffered and only flushed when the block fills up,
+         * before the interpreter blocks waiting on an input stream, when run returns and when the interpreter is
+         * destroyed. By default it writes to standard output, interpreters started from a checkpoint get their own.
+         */
+        [[nodiscard]] std::ostream& out() noexcept { return _sink->stream(); }
+        [[nodiscard]] OutputSink& getOutputSink() noexcept { return *_sink; }
+        /**
+         * Replace the output sink, the old one is flushed first
+         */
+        void setOutputSink(std::unique_ptr<OutputSink> sink);
+        /**
+         * @return false if the output could not be written
+         */
+        bool flushOutput() { return _sink->flush(); }
+        /**
+         * Start or stop counting which characters are dispatched back to back, see fuse
+         */
+        void profilePairs(bool enable) noexcept;
+        [[nodiscard]] const PairProfile& getPairProfile() const noexcept { return _pairProfile; }
+        void resetPairProfile() noexcept { _pairProfile.reset(); }
+        /**
+         * Dispatch the most frequent pairs of a profile as one. After the first character of a pair has run, the
+         * second one is dispatched straight away if it is the next buffered character of the same input source and
+         * the current table would have dispatched it anyway (it does not consume spans). Either character is looked
+         * up again whenever its table changes, so the result is always the same as dispatching them one at a time.
+         * Interpreters started from a checkpoint keep the pairs that were fused when it was taken but do not
+         * carry on profiling.
+         * @param profile The profile to take pairs from, usually getPairProfile or one loaded from a file
+         * @param limit The most pairs to fuse
+         * @param minimum Pairs seen fewer times than this are not fused
+         * @return The number of pairs fused
+         */
+        std::size_t fuse(const PairProfile& profile, std::size_t limit = 64, PairProfile::Count minimum = 16);
+        /**
+         * Go back to dispatching one character at a time
+         */
+        void unfuse() noexcept;
+        [[nodiscard]] const FusedPairs<Interpreter>& getFusedPairs() const noexcept { return _fusedPairs; }
+    private:
+        [[nodiscard]] Conclave::GenericTable_t* currentTable() const noexcept { return _current; }
+        /**
+         * Get a conclave this interpreter can change, the shared one is copied the first time this is called
+         */
+        Conclave& ownTables();
+        /**
+         * Point _current at the top of the execution stack
+         */
+        void refreshCurrent() noexcept;
+        /**
+         * Hand the buffered characters up to the next terminator of the current table to it in one go
+         * @return true if anything was consumed
+         */
+        bool consumeSpan();
+        /**
+         * Copy borrowed output into the output buffer, call this before the current input buffer is refilled or
+         * discarded
+         */
+        void pinOutput() {
+            if (!_borrowedOutput.empty()) {
+                _output.assign(_borrowedOutput);
+                _borrowedOutput = { };
+            }
+        }
+        void pushInput(InputSource&& source);
+        void dispatch(char c);
+        /**
+         * The slow side of dispatch, taken while pairs are being profiled or fused
+         */
+        void dispatchPair(char c);
+        void drainInputAbove(std::size_t depth);
     private:
         DataStack _dataStack;
         ExecutionStack _executionStack;
-        Conclave _tables;
+        SharedConclave _tables;
+        // set once this interpreter has its own copy of the conclave, _tables points at the same object
+        std::shared_ptr<Conclave> _ownedTables;
+        // cached from the top of the execution stack so dispatch does not have to go through the conclave
+        Conclave::GenericTable_t* _current = nullptr;
+        // the terminators of the current table, empty when every character has to be dispatched
+        std::string_view _currentTerminators;
         bool _executing = true;
         StreamStack _inputStreams;
-        std::stringstream _currentOutputStream;
+        // strings are built in _output, or in place inside of the input buffer when _borrowedOutput is set
+        std::string _output;
+        std::string_view _borrowedOutput;
         MemorySpace _memory;
-        std::stringstream _previousExecution;
+        // bytes fed but not read yet, they are swapped into _feeding and read in place once the input stack is empty.
+        // _feeding lives on the heap so what is borrowed from it stays put when the interpreter is moved, a short
+        // string would otherwise be stored inside the interpreter itself.
+        std::string _pending;
+        std::unique_ptr<std::string> _feeding = std::make_unique<std::string>();
+        bool _inputClosed = false;
+        bool _stepping = false;
+        Trace _trace;
+        Counters _counters;
+        // bumped whenever a source is pushed onto or popped off of the input stack
+        std::uint64_t _inputEpoch = 0;
+        // set while pairs are profiled or fused so dispatch only has a single flag to check
+        bool _pairing = false;
+        bool _profilingPairs = false;
+        PairProfile _pairProfile;
+        FusedPairs<Interpreter> _fusedPairs;
+        // what was dispatched last, for the pair profile
+        TableHandle _lastTable = InvalidTableHandle;
+        char _lastCharacter = 0;
+        std::uint64_t _lastEpoch = 0;
+        std::unique_ptr<OutputSink> _sink = OutputSink::fileDescriptor(STDOUT_FILENO);
     private:
         static inline StreamType noStream{ ObservedInputStream (nullptr) };
     };
+    /**
+     * @brief The frozen state of an interpreter, see Interpreter::checkpoint
+     */
+    struct Interpreter::Checkpoint {
+        explicit Checkpoint(const Interpreter& source);
+        SharedConclave tables;
+        MemorySnapshot memory;
+        DataStack dataStack;
+        ExecutionStack executionStack;
+        StreamStack inputStreams;
+        std::string output;
+        std::string pending;
+        bool executing;
+        bool inputClosed;
+        Trace trace;
+        Counters counters;
+        FusedPairs<Interpreter> fusedPairs;
+        /**
+         * @return A new interpreter which continues from this checkpoint
+         */
+        [[nodiscard]] Interpreter fork() const { return Interpreter { *this }; }
+    };
     void displayCurrentTableContents(Deception::Interpreter& interpreter, char);
     void displayTopItemOnDataStack(Deception::Interpreter& interpreter, char);
+    void displayCounters(Deception::Interpreter& interpreter, char);
 } // end namespace Deception
 #endif //DECEPTION_INTERPRETER_H
@@ -0,0 +1,95 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Json.h>
+
+namespace Deception {
+    namespace {
+        constexpr bool continuation(unsigned char value) noexcept { return (value & 0xC0) == 0x80; }
+        /**
+         * @return The length of the well formed UTF-8 sequence at the start of str or zero if there is none, overlong
+         * encodings, surrogates and anything past U+10FFFF are not well formed
+         */
+        constexpr std::size_t sequenceLength(std::string_view str) noexcept {
+            auto at = [str](std::size_t index) noexcept { return static_cast<unsigned char>(str[index]); };
+            auto lead = at(0);
+            std::size_t length = 0;
+            unsigned char low = 0x80;
+            unsigned char high = 0xBF;
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                length = 2;
+            } else if (lead >= 0xE0 && lead <= 0xEF) {
+                length = 3;
+                low = lead == 0xE0 ? 0xA0 : 0x80;
+                high = lead == 0xED ? 0x9F : 0xBF;
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                length = 4;
+                low = lead == 0xF0 ? 0x90 : 0x80;
+                high = lead == 0xF4 ? 0x8F : 0xBF;
+            } else {
+                return 0;
+            }
+            if (str.size() < length || at(1) < low || at(1) > high) {
+                return 0;
+            }
+            for (std::size_t i = 2; i < length; ++i) {
+                if (!continuation(at(i))) {
+                    return 0;
+                }
+            }
+            return length;
+        }
+    }
+    std::string
+    jsonEscape(std::string_view str) {
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string result;
+        result.reserve(str.size());
+        // control characters and bytes which are not part of well formed UTF-8 are written as the code point of the byte
+        auto escape = [&result](unsigned char value) {
+            result += "\\u00";
+            result.push_back(digits[value >> 4]);
+            result.push_back(digits[value & 0xF]);
+        };
+        for (std::size_t i = 0; i < str.size(); ++i) {
+            auto c = str[i];
+            auto value = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+                result.push_back(c);
+            } else if (value < 0x20) {
+                escape(value);
+            } else if (value < 0x80) {
+                result.push_back(c);
+            } else if (auto length = sequenceLength(str.substr(i)); length != 0) {
+                result.append(str.substr(i, length));
+                i += length - 1;
+            } else {
+                escape(value);
+            }
+        }
+        return result;
+    }
+} // end namespace Deception
@@ -0,0 +1,64 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_MAPPEDFILE_H
+#define DECEPTION_MAPPEDFILE_H
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+namespace Deception {
+    /**
+     * @brief A read only view of a file which has been mapped into memory. The interpreter reads straight out of the
+     * mapping so the contents never get copied through any stream buffers.
+     */
+    class MappedFile {
+    public:
+        using SharedPtr = std::shared_ptr<MappedFile>;
+        /**
+         * Map the given file into memory
+         * @param path The path to the file to map
+         * @return The mapping or nullptr if the file could not be opened or mapped
+         */
+        static SharedPtr open(const std::string& path);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+        ~MappedFile();
+        [[nodiscard]] const char* data() const noexcept { return _data; }
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+        [[nodiscard]] std::string_view view() const noexcept { return { _data, _size }; }
+        const char* begin() const noexcept { return _data; }
+        const char* end() const noexcept { return _data + _size; }
+    private:
+        MappedFile(const char* data, std::size_t size) noexcept : _data(data), _size(size) { }
+    private:
+        const char* _data;
+        std::size_t _size;
+    };
+} // end namespace Deception
+#endif //DECEPTION_MAPPEDFILE_H
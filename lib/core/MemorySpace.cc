@@ -27,9 +27,513 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 
 #include "MemorySpace.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <system_error>
+#include <utility>
+#include <array>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+// SSE2 is always there on x86-64, 32-bit x86 is left on the portable path since it does not have _mm_cvtsi128_si64
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define DECEPTION_MEMORY_X86_64
+#endif
 
 namespace Deception {
-    MemorySpace::MemorySpace(std::size_t capacity) : _capacity(capacity), _backingStorage(std::make_unique<char[]>(capacity)) { }
-    MemorySpace::MemorySpace(Address capacity) : MemorySpace(static_cast<std::size_t>(capacity == 0 ? 0x1'0000'0000 : capacity)) { }
-
+    namespace {
+        std::size_t
+        pageSize() noexcept {
+            static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+        bool
+        writeAll(int fd, const char* data, std::size_t length, std::uint64_t offset) noexcept {
+            while (length > 0) {
+                auto amount = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+                if (amount <= 0) {
+                    return false;
+                }
+                data += amount;
+                offset += static_cast<std::uint64_t>(amount);
+                length -= static_cast<std::size_t>(amount);
+            }
+            return true;
+        }
+        /**
+         * @brief The page table entries of this process (see the kernel's pagemap documentation), they tell pages
+         * which were never faulted in apart from ones which have been swapped out
+         */
+        class PageMap {
+        public:
+            static constexpr std::uint64_t Present = 1ull << 63;
+            static constexpr std::uint64_t Swapped = 1ull << 62;
+            /// set for pages of a file or of shared anonymous memory, clear for private copies
+            static constexpr std::uint64_t FilePage = 1ull << 61;
+#ifdef __linux__
+            PageMap() noexcept : _fd(::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC)) { }
+#else
+            PageMap() noexcept = default;
+#endif
+            PageMap(const PageMap&) = delete;
+            PageMap& operator=(const PageMap&) = delete;
+            ~PageMap() {
+                if (_fd >= 0) {
+                    ::close(_fd);
+                }
+            }
+            [[nodiscard]] bool valid() const noexcept { return _fd >= 0; }
+            /**
+             * Read the entries of count pages starting at the page holding address
+             * @return false if the entries could not be read
+             */
+            bool read(const char* address, std::size_t count, std::uint64_t* entries) const noexcept {
+                auto size = count * sizeof(std::uint64_t);
+                auto offset = reinterpret_cast<std::uintptr_t>(address) / pageSize() * sizeof(std::uint64_t);
+                return ::pread(_fd, entries, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+            }
+        private:
+            int _fd = -1;
+        };
+        /**
+         * @brief Walks the data extents of the file a private mapping was made from, everything else is a hole and
+         * reads back as zero. Without SEEK_DATA the whole file counts as data.
+         */
+        class OriginExtents {
+        public:
+            OriginExtents(int fd, std::uint64_t offset, std::size_t length) noexcept : _fd(fd), _offset(offset), _length(length) { }
+            /**
+             * @return true if any part of the range holds data, ranges have to be asked for in increasing order
+             */
+            bool hasData(std::size_t start, std::size_t length) noexcept {
+                if (_fd < 0) {
+                    return false;
+                }
+                while (_dataEnd <= start && _dataStart < _length) {
+                    advance(std::max(start, _dataEnd));
+                }
+                return _dataStart < start + length && start < _dataEnd;
+            }
+        private:
+            void advance(std::size_t from) noexcept {
+#ifdef SEEK_DATA
+                auto data = ::lseek(_fd, static_cast<off_t>(_offset + from), SEEK_DATA);
+                if (data < 0) {
+                    // ENXIO means there is no data past this point, anything else means holes are not supported
+                    _dataStart = errno == ENXIO ? _length : from;
+                    _dataEnd = _length;
+                    return;
+                }
+                auto hole = ::lseek(_fd, data, SEEK_HOLE);
+                _dataStart = std::min(_length, static_cast<std::size_t>(static_cast<std::uint64_t>(data) - _offset));
+                _dataEnd = hole < 0 ? _length : std::min(_length, static_cast<std::size_t>(static_cast<std::uint64_t>(hole) - _offset));
+#else
+                _dataStart = from;
+                _dataEnd = _length;
+#endif
+            }
+        private:
+            int _fd;
+            std::uint64_t _offset;
+            std::size_t _length;
+            std::size_t _dataStart = 0;
+            std::size_t _dataEnd = 0;
+        };
+        /**
+         * Copy part of one file into another through a bounded buffer. Pages of zeros are left as holes, reading a
+         * hole of a shared memory file through a mapping fills it in so the source may hold plenty of those.
+         */
+        bool
+        copyRange(int from, std::uint64_t source, int to, std::uint64_t destination, std::size_t length, std::vector<char>& buffer) noexcept {
+            constexpr std::size_t ChunkSize = 1024 * 1024;
+            static const std::vector<char> zeros(pageSize(), 0);
+            try {
+                buffer.resize(std::min(ChunkSize, std::max(buffer.size(), length)));
+            } catch (...) {
+                return false;
+            }
+            while (length > 0) {
+                auto amount = ::pread(from, buffer.data(), std::min(buffer.size(), length), static_cast<off_t>(source));
+                if (amount < 0 && errno == EINTR) {
+                    continue;
+                } else if (amount <= 0) {
+                    return false;
+                }
+                auto count = static_cast<std::size_t>(amount);
+                std::size_t runStart = 0;
+                std::size_t runLength = 0;
+                for (std::size_t offset = 0; offset <= count; ) {
+                    auto size = std::min(zeros.size(), count - offset);
+                    if (size > 0 && std::memcmp(buffer.data() + offset, zeros.data(), size) != 0) {
+                        runStart = runLength == 0 ? offset : runStart;
+                        runLength += size;
+                    } else if (runLength > 0) {
+                        if (!writeAll(to, buffer.data() + runStart, runLength, destination + runStart)) {
+                            return false;
+                        }
+                        runLength = 0;
+                    }
+                    if (size == 0) {
+                        break;
+                    }
+                    offset += size;
+                }
+                source += count;
+                destination += count;
+                length -= count;
+            }
+            return true;
+        }
+        int
+        anonymousFile() noexcept {
+#ifdef __linux__
+            return ::memfd_create("deception-snapshot", MFD_CLOEXEC);
+#else
+            char path[] = "/tmp/deception-snapshot-XXXXXX";
+            int fd = ::mkstemp(path);
+            if (fd >= 0) {
+                ::unlink(path);
+            }
+            return fd;
+#endif
+        }
+        /**
+         * Slicing by eight tables for the reflected CRC-32 polynomial, table 0 is the classic byte at a time table
+         */
+        constexpr auto CrcTables = [] {
+            std::array<std::array<std::uint32_t, 0x100>, 8> result { };
+            for (std::uint32_t i = 0; i < 0x100; ++i) {
+                auto crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+                }
+                result[0][i] = crc;
+            }
+            for (std::uint32_t i = 0; i < 0x100; ++i) {
+                for (std::size_t table = 1; table < result.size(); ++table) {
+                    result[table][i] = (result[table - 1][i] >> 8) ^ result[0][result[table - 1][i] & 0xFF];
+                }
+            }
+            return result;
+        }();
+        char*
+        reserve(std::size_t capacity, PagePolicy policy) {
+            if (capacity == 0) {
+                return nullptr;
+            }
+            // anonymous mappings are zero on demand and MAP_NORESERVE keeps the kernel from accounting for the whole
+            // space up front, pages are only committed when they are first touched
+            auto* mapping = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mapping == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+#ifdef MADV_HUGEPAGE
+            if (policy == PagePolicy::HugePages) {
+                // this is only a hint, if transparent huge pages are disabled we just keep going with regular pages
+                ::madvise(mapping, capacity, MADV_HUGEPAGE);
+            }
+#endif
+            return static_cast<char*>(mapping);
+        }
+    }
+    MemorySpace::MemorySpace(Address capacity, PagePolicy policy) : _capacity(capacity == 0 ? 0x1'0000'0000 : static_cast<std::size_t>(capacity)), _policy(policy), _backingStorage(reserve(_capacity, policy)) { }
+    MemorySpace::MemorySpace(MemorySpace&& other) noexcept : _capacity(std::exchange(other._capacity, 0)), _policy(other._policy), _backingStorage(std::exchange(other._backingStorage, nullptr)), _fileBacked(other._fileBacked), _origin(std::exchange(other._origin, -1)), _originOffset(other._originOffset) { }
+    std::optional<MemorySpace>
+    MemorySpace::map(int fd, std::size_t offset, std::size_t length, MappingMode mode) {
+        if (length == 0 || length > 0x1'0000'0000) {
+            return std::nullopt;
+        }
+        auto flags = (mode == MappingMode::Shared ? MAP_SHARED : MAP_PRIVATE) | MAP_NORESERVE;
+        auto* mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, fd, static_cast<off_t>(offset));
+        if (mapping == MAP_FAILED) {
+            return std::nullopt;
+        }
+        // pages of a private mapping which were never written to still read from the file, holding onto it lets
+        // writeTo copy those straight out of the file instead of faulting them in
+        auto origin = mode == MappingMode::Private ? ::fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1;
+        return MemorySpace(static_cast<char*>(mapping), length, origin, offset);
+    }
+    std::optional<MemorySpace>
+    MemorySpace::map(const std::string& path, MappingMode mode) {
+        int fd = ::open(path.c_str(), (mode == MappingMode::Shared ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+        std::optional<MemorySpace> result;
+        if (struct stat info { }; ::fstat(fd, &info) == 0) {
+            result = map(fd, 0, static_cast<std::size_t>(info.st_size), mode);
+        }
+        ::close(fd);
+        return result;
+    }
+    MemorySpace&
+    MemorySpace::operator=(MemorySpace&& other) noexcept {
+        if (this != &other) {
+            if (_backingStorage) {
+                ::munmap(_backingStorage, _capacity);
+            }
+            _capacity = std::exchange(other._capacity, 0);
+            _policy = other._policy;
+            if (_origin >= 0) {
+                ::close(_origin);
+            }
+            _backingStorage = std::exchange(other._backingStorage, nullptr);
+            _fileBacked = other._fileBacked;
+            _origin = std::exchange(other._origin, -1);
+            _originOffset = other._originOffset;
+        }
+        return *this;
+    }
+    MemorySpace::~MemorySpace() {
+        if (_backingStorage) {
+            ::munmap(_backingStorage, _capacity);
+        }
+        if (_origin >= 0) {
+            ::close(_origin);
+        }
+    }
+    void
+    MemorySpace::release(std::size_t start, std::size_t length) noexcept {
+        if (start >= _capacity) {
+            return;
+        }
+        auto finish = start + std::min(length, _capacity - start);
+        if (_fileBacked) {
+            // dropping the pages of a file mapping would bring back the file contents instead of zeros
+            std::memset(_backingStorage + start, 0, finish - start);
+            return;
+        }
+        static const auto pageSize = Deception::pageSize();
+        // only whole pages can be handed back, the partial pages at either end are cleared by hand instead
+        auto firstPage = (start + pageSize - 1) / pageSize * pageSize;
+        auto lastPage = finish / pageSize * pageSize;
+        if (firstPage >= lastPage) {
+            std::memset(_backingStorage + start, 0, finish - start);
+            return;
+        }
+        std::memset(_backingStorage + start, 0, firstPage - start);
+        std::memset(_backingStorage + lastPage, 0, finish - lastPage);
+        ::madvise(_backingStorage + firstPage, lastPage - firstPage, MADV_DONTNEED);
+    }
+    bool
+    MemorySpace::writeTo(int fd, std::uint64_t base) const noexcept {
+        auto page = pageSize();
+        auto pageCount = (_capacity + page - 1) / page;
+        /*
+         * The page table tells us which pages have to be read through the mapping:
+         * - an anonymous page which is neither present nor swapped out was never faulted in (or was released) so it is
+         *   known to be zero
+         * - a page of a private file mapping which is not a private copy was never written to so it still holds what
+         *   the file holds, those are copied out of the file and only where the file has data
+         * Everything else, shared mappings included, is read and checked against zero.
+         */
+        PageMap pages;
+        bool usePageMap = pages.valid() && (!_fileBacked || _origin >= 0);
+        std::array<std::uint64_t, 512> entries { };
+        static const std::vector<char> zeros(pageSize(), 0);
+        std::vector<char> buffer;
+        OriginExtents extents(_origin, _originOffset, _capacity);
+        enum class Source {
+            Mapping,
+            Origin,
+        };
+        Source runSource = Source::Mapping;
+        std::size_t runStart = 0;
+        std::size_t runLength = 0;
+        auto flush = [&]() {
+            bool result = true;
+            if (runLength == 0) {
+                return result;
+            } else if (runSource == Source::Mapping) {
+                result = writeAll(fd, _backingStorage + runStart, runLength, base + runStart);
+            } else {
+                result = copyRange(_origin, _originOffset + runStart, fd, base + runStart, runLength, buffer);
+            }
+            runLength = 0;
+            return result;
+        };
+        auto extend = [&](Source source, std::size_t offset, std::size_t length) {
+            if (runLength > 0 && runSource != source && !flush()) {
+                return false;
+            }
+            if (runLength == 0) {
+                runSource = source;
+                runStart = offset;
+            }
+            runLength += length;
+            return true;
+        };
+        for (std::size_t i = 0; i < pageCount; ++i) {
+            auto offset = i * page;
+            auto length = std::min(page, _capacity - offset);
+            if (usePageMap && i % entries.size() == 0) {
+                usePageMap = pages.read(_backingStorage + offset, std::min(entries.size(), pageCount - i), entries.data());
+            }
+            auto entry = entries[i % entries.size()];
+            bool ownPage = !usePageMap;
+            if (usePageMap) {
+                // a swapped out page of a private file mapping is always a private copy, file pages are dropped instead
+                ownPage = _fileBacked ? ((entry & PageMap::Swapped) != 0 || ((entry & PageMap::Present) != 0 && (entry & PageMap::FilePage) == 0)) : (entry & (PageMap::Present | PageMap::Swapped)) != 0;
+            }
+            bool keep = false;
+            Source source = Source::Mapping;
+            if (ownPage) {
+                keep = std::memcmp(_backingStorage + offset, zeros.data(), length) != 0;
+            } else if (_fileBacked) {
+                keep = extents.hasData(offset, length);
+                source = Source::Origin;
+            }
+            if (!(keep ? extend(source, offset, length) : flush())) {
+                return false;
+            }
+        }
+        return flush();
+    }
+    MemorySnapshot::MemorySnapshot(const MemorySpace& space) : _fd(anonymousFile()), _capacity(space.size()) {
+        if (_fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "unable to create a memory snapshot");
+        }
+        // the file starts out as one big hole so only the pages in use take up any room
+        if (::ftruncate(_fd, static_cast<off_t>(_capacity)) != 0 || !space.writeTo(_fd, 0)) {
+            auto error = errno;
+            ::close(_fd);
+            throw std::system_error(error, std::generic_category(), "unable to write a memory snapshot");
+        }
+    }
+    MemorySnapshot::MemorySnapshot(MemorySnapshot&& other) noexcept : _fd(std::exchange(other._fd, -1)), _capacity(std::exchange(other._capacity, 0)) { }
+    MemorySnapshot&
+    MemorySnapshot::operator=(MemorySnapshot&& other) noexcept {
+        if (this != &other) {
+            if (_fd >= 0) {
+                ::close(_fd);
+            }
+            _fd = std::exchange(other._fd, -1);
+            _capacity = std::exchange(other._capacity, 0);
+        }
+        return *this;
+    }
+    MemorySnapshot::~MemorySnapshot() {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+    MemorySpace
+    MemorySnapshot::map() const {
+        if (auto result = MemorySpace::map(_fd, 0, _capacity, MappingMode::Private); result) {
+            return std::move(*result);
+        }
+        throw std::system_error(errno, std::generic_category(), "unable to map a memory snapshot");
+    }
+    bool
+    MemorySpace::fill(std::size_t start, std::size_t length, char value) noexcept {
+        if (!contains(start, length)) {
+            return false;
+        }
+        std::memset(_backingStorage + start, value, length);
+        return true;
+    }
+    bool
+    MemorySpace::move(std::size_t destination, std::size_t source, std::size_t length) noexcept {
+        if (!contains(destination, length) || !contains(source, length)) {
+            return false;
+        }
+        std::memmove(_backingStorage + destination, _backingStorage + source, length);
+        return true;
+    }
+    std::optional<int>
+    MemorySpace::compare(std::size_t first, std::size_t second, std::size_t length) const noexcept {
+        if (!contains(first, length) || !contains(second, length)) {
+            return std::nullopt;
+        }
+        return std::memcmp(_backingStorage + first, _backingStorage + second, length);
+    }
+    std::optional<int>
+    MemorySpace::compare(std::size_t start, std::string_view bytes) const noexcept {
+        if (!contains(start, bytes.size())) {
+            return std::nullopt;
+        }
+        return std::memcmp(_backingStorage + start, bytes.data(), bytes.size());
+    }
+    std::optional<std::size_t>
+    MemorySpace::find(std::size_t start, std::size_t length, char value) const noexcept {
+        if (!contains(start, length)) {
+            return std::nullopt;
+        }
+        if (auto* result = std::memchr(_backingStorage + start, static_cast<unsigned char>(value), length); result) {
+            return static_cast<std::size_t>(static_cast<const char*>(result) - _backingStorage);
+        }
+        return std::nullopt;
+    }
+    std::optional<std::size_t>
+    MemorySpace::find(std::size_t start, std::size_t length, std::string_view pattern) const noexcept {
+        if (!contains(start, length) || pattern.size() > length) {
+            return std::nullopt;
+        }
+        if (pattern.empty()) {
+            return start;
+        }
+        // look for the first byte with memchr and only compare the rest of the pattern where it shows up
+        const char* current = _backingStorage + start;
+        const char* last = _backingStorage + start + (length - pattern.size());
+        while (current <= last) {
+            auto* candidate = static_cast<const char*>(std::memchr(current, static_cast<unsigned char>(pattern.front()), static_cast<std::size_t>(last - current) + 1));
+            if (!candidate) {
+                break;
+            }
+            if (std::memcmp(candidate + 1, pattern.data() + 1, pattern.size() - 1) == 0) {
+                return static_cast<std::size_t>(candidate - _backingStorage);
+            }
+            current = candidate + 1;
+        }
+        return std::nullopt;
+    }
+    std::optional<std::uint32_t>
+    MemorySpace::sum32(std::size_t start, std::size_t length) const noexcept {
+        if (!contains(start, length)) {
+            return std::nullopt;
+        }
+        const auto* current = reinterpret_cast<const unsigned char*>(_backingStorage + start);
+        const auto* end = current + length;
+        std::uint64_t total = 0;
+#ifdef DECEPTION_MEMORY_X86_64
+        // psadbw against zero adds up eight bytes at a time into each half of the register
+        auto zero = _mm_setzero_si128();
+        auto sums = _mm_setzero_si128();
+        for (; end - current >= 16; current += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(block, zero));
+        }
+        total = static_cast<std::uint64_t>(_mm_cvtsi128_si64(sums)) + static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+        for (; current != end; ++current) {
+            total += *current;
+        }
+        return static_cast<std::uint32_t>(total);
+    }
+    std::optional<std::uint32_t>
+    MemorySpace::crc32(std::size_t start, std::size_t length) const noexcept {
+        if (!contains(start, length)) {
+            return std::nullopt;
+        }
+        const auto* current = reinterpret_cast<const unsigned char*>(_backingStorage + start);
+        const auto* end = current + length;
+        std::uint32_t crc = 0xFFFF'FFFF;
+        for (; end - current >= 8; current += 8) {
+            // assembled by hand so the table lookups see little endian words on any host, this folds into a plain load
+            std::uint32_t low = current[0] | (current[1] << 8) | (current[2] << 16) | (static_cast<std::uint32_t>(current[3]) << 24);
+            std::uint32_t high = current[4] | (current[5] << 8) | (current[6] << 16) | (static_cast<std::uint32_t>(current[7]) << 24);
+            low ^= crc;
+            crc = CrcTables[7][low & 0xFF] ^ CrcTables[6][(low >> 8) & 0xFF] ^ CrcTables[5][(low >> 16) & 0xFF] ^ CrcTables[4][low >> 24] ^
+                  CrcTables[3][high & 0xFF] ^ CrcTables[2][(high >> 8) & 0xFF] ^ CrcTables[1][(high >> 16) & 0xFF] ^ CrcTables[0][high >> 24];
+        }
+        for (; current != end; ++current) {
+            crc = (crc >> 8) ^ CrcTables[0][(crc ^ *current) & 0xFF];
+        }
+        return crc ^ 0xFFFF'FFFF;
+    }
 }
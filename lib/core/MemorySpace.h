@@ -29,53 +29,244 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef DECEPTION_MEMORYSPACE_H
 #define DECEPTION_MEMORYSPACE_H
 #include <memory>
+#include <array>
+#include <bit>
+#include <concepts>
 #include <cstdint>
+#include <cstring>
 #include <optional>
+#include <string_view>
 #include <core/Value.h>
 #include <iterator>
+#include <string>
 namespace Deception {
     /**
-     * @brief A block of memory which holds onto characters not bytes.
+     * @brief How the pages backing a MemorySpace should be handled
+     */
+    enum class PagePolicy {
+        /// regular pages
+        Normal,
+        /// ask the kernel to back the space with transparent huge pages where it can
+        HugePages,
+    };
+    /**
+     * @brief How writes to a file backed MemorySpace are handled
+     */
+    enum class MappingMode {
+        /// copy on write, the file is never modified
+        Private,
+        /// writes go straight back to the file
+        Shared,
+    };
+    /**
+     * @brief A block of memory which holds onto characters not bytes. The space is reserved as an anonymous mapping
+     * so constructing one is cheap no matter the capacity, pages read back as zero and are only committed once they
+     * are touched.
      */
     class MemorySpace {
-    private:
-        explicit MemorySpace(std::size_t capacity);
     public:
         /**
          * Construct a memory space with four giga characters or less (use 0 to specify the full 4G)
          * @param capacity The number of characters that make up this space, use 0 to allocate the full 4G
+         * @param policy Should transparent huge pages be requested for this space
          */
-        explicit MemorySpace(Address capacity = 0);
+        explicit MemorySpace(Address capacity = 0, PagePolicy policy = PagePolicy::Normal);
+        /**
+         * Map part of an already open file as a memory space, no data is read until pages are touched
+         * @param fd The file to map, it does not need to stay open afterwards
+         * @param offset Where the space starts in the file, must be a multiple of the page size
+         * @param length The number of characters in the space (at most 4G)
+         * @param mode Should writes be private to this space or go back to the file
+         * @return The space or std::nullopt if the region could not be mapped
+         */
+        static std::optional<MemorySpace> map(int fd, std::size_t offset, std::size_t length, MappingMode mode);
+        /**
+         * Map an entire file (a ROM image for instance) as a memory space
+         * @return The space or std::nullopt if the file could not be opened or mapped
+         */
+        static std::optional<MemorySpace> map(const std::string& path, MappingMode mode);
+        MemorySpace(const MemorySpace&) = delete;
+        MemorySpace(MemorySpace&& other) noexcept;
+        MemorySpace& operator=(const MemorySpace&) = delete;
+        MemorySpace& operator=(MemorySpace&& other) noexcept;
+        ~MemorySpace();
         /**
          * Get the number of characters stored in this memory pool
          * @return The number of characters available in this memory pool
          */
         [[nodiscard]] constexpr auto size() const noexcept { return _capacity; }
+        [[nodiscard]] constexpr auto getPagePolicy() const noexcept { return _policy; }
+        [[nodiscard]] constexpr bool isFileBacked() const noexcept { return _fileBacked; }
+        /**
+         * Hand the pages backing the given range back to the operating system, the range reads back as zero afterwards.
+         * File backed spaces have no pages to give back so the range is just cleared.
+         * @param start The first character to release
+         * @param length The number of characters to release, clamped to the end of the space
+         */
+        void release(std::size_t start, std::size_t length) noexcept;
+        /**
+         * Hand every page in this space back to the operating system
+         */
+        void release() noexcept { release(0, _capacity); }
+        /**
+         * Write every page of this space that is not all zeros to a file, the rest is left as holes. Pages of an
+         * anonymous space which were never faulted in are skipped without being read, pages which were swapped out
+         * are read back like any other. Pages of a private file mapping (a branch mapped from a MemorySnapshot for
+         * instance) which were never written to are copied straight out of the file where it has data, so only the
+         * pages this space changed are read through the mapping.
+         * @param fd The file to write to
+         * @param offset Where the space starts in the file
+         * @return false if a write failed
+         */
+        bool writeTo(int fd, std::uint64_t offset) const noexcept;
+        /**
+         * @return true if the whole range lies inside of this space
+         */
+        [[nodiscard]] constexpr bool contains(std::size_t start, std::size_t length) const noexcept { return start <= _capacity && length <= _capacity - start; }
+        /*
+         * Bulk operations, each one checks its range(s) first and does nothing if they do not fit inside of the space.
+         * The byte level work is done by the C library, which picks a vectorized implementation for the processor.
+         */
+        /**
+         * Set every character in the range to the given value
+         * @return false if the range does not fit
+         */
+        bool fill(std::size_t start, std::size_t length, char value) noexcept;
+        /**
+         * Copy a range to another place in the space, the ranges may overlap
+         * @return false if either range does not fit
+         */
+        bool move(std::size_t destination, std::size_t source, std::size_t length) noexcept;
+        /**
+         * Compare two ranges byte by byte as unsigned values
+         * @return Less than, equal to or greater than zero like memcmp, std::nullopt if either range does not fit
+         */
+        [[nodiscard]] std::optional<int> compare(std::size_t first, std::size_t second, std::size_t length) const noexcept;
+        /**
+         * Compare a range against the given bytes
+         */
+        [[nodiscard]] std::optional<int> compare(std::size_t start, std::string_view bytes) const noexcept;
+        /**
+         * @return The address of the first occurrence of value in the range, std::nullopt if there is none or the range
+         * does not fit
+         */
+        [[nodiscard]] std::optional<std::size_t> find(std::size_t start, std::size_t length, char value) const noexcept;
+        /**
+         * @return The address of the first occurrence of pattern which lies entirely inside of the range
+         */
+        [[nodiscard]] std::optional<std::size_t> find(std::size_t start, std::size_t length, std::string_view pattern) const noexcept;
+        /**
+         * @return The sum of every byte in the range as unsigned values, modulo 2^32
+         */
+        [[nodiscard]] std::optional<std::uint32_t> sum32(std::size_t start, std::size_t length) const noexcept;
+        /**
+         * @return The CRC-32 (IEEE 802.3, the one used by zip and most ROM tools) of the range
+         */
+        [[nodiscard]] std::optional<std::uint32_t> crc32(std::size_t start, std::size_t length) const noexcept;
+        /**
+         * Read an integer out of the space
+         * @tparam T Integer, Ordinal, Address or any other integral type
+         * @param address Where the first byte of the value is
+         * @param order The byte order the value is stored in
+         * @return The value or std::nullopt if it does not fit inside of the space
+         */
+        template<std::integral T>
+        [[nodiscard]] std::optional<T> load(std::size_t address, std::endian order = std::endian::little) const noexcept {
+            if (!contains(address, sizeof(T))) {
+                return std::nullopt;
+            }
+            T value;
+            std::memcpy(&value, _backingStorage + address, sizeof(T));
+            return order == std::endian::native ? value : byteSwap(value);
+        }
+        /**
+         * Write an integer into the space
+         * @return false if the value does not fit inside of the space
+         */
+        template<std::integral T>
+        bool store(std::size_t address, T value, std::endian order = std::endian::little) noexcept {
+            if (!contains(address, sizeof(T))) {
+                return false;
+            }
+            if (order != std::endian::native) {
+                value = byteSwap(value);
+            }
+            std::memcpy(_backingStorage + address, &value, sizeof(T));
+            return true;
+        }
         [[nodiscard]] char& get(Address index) noexcept { return _backingStorage[index]; }
         [[nodiscard]] const char& get(Address index) const noexcept { return _backingStorage[index]; }
         [[nodiscard]] char& operator[](Address index) noexcept { return get(index); }
         [[nodiscard]] const char& operator[](Address index) const noexcept { return get(index); }
-        auto rbegin() noexcept { return std::reverse_iterator(_backingStorage.get() + _capacity); }
-        auto rbegin() const noexcept { return std::reverse_iterator(_backingStorage.get() + _capacity); }
-        auto crbegin() const noexcept { return std::reverse_iterator(_backingStorage.get() + _capacity); }
-        auto rend() noexcept { return std::reverse_iterator(_backingStorage.get()); }
-        auto rend() const noexcept { return std::reverse_iterator(_backingStorage.get()); }
-        auto crend() const noexcept { return std::reverse_iterator(_backingStorage.get()); }
-        auto begin() const noexcept { return _backingStorage.get(); }
-        auto begin() noexcept { return _backingStorage.get(); }
-        auto begin(Address start) const noexcept { return _backingStorage.get() + start; }
-        auto begin(Address start) noexcept { return _backingStorage.get() + start; }
-        auto cbegin() const noexcept { return _backingStorage.get(); }
-        auto end() const noexcept { return _backingStorage.get() + _capacity; }
-        auto end() noexcept { return _backingStorage.get() + _capacity; }
-        auto end(Address end) const noexcept { return _backingStorage.get() + end; }
-        auto end(Address end) noexcept { return _backingStorage.get() + end; }
-        auto cend() const noexcept { return _backingStorage.get() + _capacity; }
+        auto rbegin() noexcept { return std::reverse_iterator(_backingStorage + _capacity); }
+        auto rbegin() const noexcept { return std::reverse_iterator(static_cast<const char*>(_backingStorage + _capacity)); }
+        auto crbegin() const noexcept { return rbegin(); }
+        auto rend() noexcept { return std::reverse_iterator(_backingStorage); }
+        auto rend() const noexcept { return std::reverse_iterator(static_cast<const char*>(_backingStorage)); }
+        auto crend() const noexcept { return rend(); }
+        const char* begin() const noexcept { return _backingStorage; }
+        char* begin() noexcept { return _backingStorage; }
+        const char* begin(Address start) const noexcept { return _backingStorage + start; }
+        char* begin(Address start) noexcept { return _backingStorage + start; }
+        const char* cbegin() const noexcept { return _backingStorage; }
+        const char* end() const noexcept { return _backingStorage + _capacity; }
+        char* end() noexcept { return _backingStorage + _capacity; }
+        const char* end(Address end) const noexcept { return _backingStorage + end; }
+        char* end(Address end) noexcept { return _backingStorage + end; }
+        const char* cend() const noexcept { return _backingStorage + _capacity; }
         constexpr auto empty() const noexcept { return _capacity == 0; }
-        auto data() noexcept { return _backingStorage.get(); }
+        char* data() noexcept { return _backingStorage; }
+        const char* data() const noexcept { return _backingStorage; }
+    private:
+        template<std::integral T>
+        static constexpr T byteSwap(T value) noexcept {
+            if constexpr (sizeof(T) == 1) {
+                return value;
+            } else {
+                auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(value);
+                for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+                    std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+                }
+                return std::bit_cast<T>(bytes);
+            }
+        }
+        MemorySpace(char* storage, std::size_t capacity, int origin, std::uint64_t originOffset) noexcept : _capacity(capacity), _policy(PagePolicy::Normal), _backingStorage(storage), _fileBacked(true), _origin(origin), _originOffset(originOffset) { }
     private:
         std::size_t _capacity;
-        std::unique_ptr<char[]> _backingStorage;
+        PagePolicy _policy;
+        char* _backingStorage;
+        bool _fileBacked = false;
+        // the file a private mapping was made from, kept open so writeTo can copy untouched pages out of it
+        int _origin = -1;
+        std::uint64_t _originOffset = 0;
+    };
+    /**
+     * @brief A frozen copy of a MemorySpace kept in an anonymous file. Any number of spaces can be mapped from it,
+     * each one shares the pages of the snapshot and only gets its own copy of the pages it writes to.
+     */
+    class MemorySnapshot {
+    public:
+        /**
+         * Copy the touched, non zero pages of the given space, this costs as much as the space has in use and not its
+         * capacity
+         * @throws std::system_error if the snapshot cannot be created or written
+         */
+        explicit MemorySnapshot(const MemorySpace& space);
+        MemorySnapshot(const MemorySnapshot&) = delete;
+        MemorySnapshot(MemorySnapshot&& other) noexcept;
+        MemorySnapshot& operator=(const MemorySnapshot&) = delete;
+        MemorySnapshot& operator=(MemorySnapshot&& other) noexcept;
+        ~MemorySnapshot();
+        /**
+         * Make a new copy on write space with the contents of the snapshot, this only sets up a mapping so it does not
+         * depend on the size of the space
+         * @throws std::system_error if the mapping fails
+         */
+        [[nodiscard]] MemorySpace map() const;
+        [[nodiscard]] constexpr auto size() const noexcept { return _capacity; }
+    private:
+        int _fd = -1;
+        std::size_t _capacity = 0;
     };
 }
 
@@ -0,0 +1,148 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/OutputSink.h>
+#include <cerrno>
+#include <utility>
+#include <unistd.h>
+
+namespace Deception {
+    namespace {
+        bool
+        writeAll(int fd, const char* data, std::size_t length) noexcept {
+            while (length > 0) {
+                if (auto amount = ::write(fd, data, length); amount > 0) {
+                    data += amount;
+                    length -= static_cast<std::size_t>(amount);
+                } else if (amount < 0 && errno == EINTR) {
+                    continue;
+                } else {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // end namespace
+    OutputSink::Buffer::Buffer(Target target, int fd, bool closeWhenDone, std::size_t size) :
+            target(target),
+            fd(fd),
+            closeWhenDone(closeWhenDone),
+            // there is no point in holding onto much when everything is going to be thrown away anyway
+            size(target == Target::Null ? 256 : (size == 0 ? 1 : size)),
+            storage(std::make_unique_for_overwrite<char[]>(this->size)) {
+        setp(storage.get(), storage.get() + this->size);
+    }
+    OutputSink::Buffer::~Buffer() {
+        drain();
+        if (closeWhenDone && fd >= 0) {
+            ::close(fd);
+        }
+    }
+    bool
+    OutputSink::Buffer::drain() {
+        auto length = static_cast<std::size_t>(pptr() - pbase());
+        bool result = true;
+        switch (target) {
+            case Target::FileDescriptor:
+                result = writeAll(fd, pbase(), length);
+                break;
+            case Target::Memory:
+                collected.append(pbase(), length);
+                break;
+            default:
+                break;
+        }
+        setp(storage.get(), storage.get() + size);
+        return result;
+    }
+    OutputSink::Buffer::int_type
+    OutputSink::Buffer::overflow(int_type c) {
+        if (!drain()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    std::streamsize
+    OutputSink::Buffer::xsputn(const char_type* s, std::streamsize count) {
+        auto length = static_cast<std::size_t>(count);
+        if (length <= static_cast<std::size_t>(epptr() - pptr())) {
+            traits_type::copy(pptr(), s, length);
+            pbump(static_cast<int>(length));
+            return count;
+        }
+        if (!drain()) {
+            return 0;
+        }
+        if (length < size) {
+            traits_type::copy(pptr(), s, length);
+            pbump(static_cast<int>(length));
+            return count;
+        }
+        // too big to be worth buffering so it goes straight to the target
+        switch (target) {
+            case Target::FileDescriptor:
+                return writeAll(fd, s, length) ? count : 0;
+            case Target::Memory:
+                collected.append(s, length);
+                return count;
+            default:
+                return count;
+        }
+    }
+    OutputSink::OutputSink(Target target, int fd, bool closeWhenDone, std::size_t bufferSize) : _buffer(target, fd, closeWhenDone, bufferSize), _stream(&_buffer) { }
+    OutputSink::~OutputSink() {
+        _stream.flush();
+    }
+    std::unique_ptr<OutputSink>
+    OutputSink::fileDescriptor(int fd, bool closeWhenDone, std::size_t bufferSize) {
+        return std::unique_ptr<OutputSink>(new OutputSink(Target::FileDescriptor, fd, closeWhenDone, bufferSize));
+    }
+    std::unique_ptr<OutputSink>
+    OutputSink::memory(std::size_t bufferSize) {
+        return std::unique_ptr<OutputSink>(new OutputSink(Target::Memory, -1, false, bufferSize));
+    }
+    std::unique_ptr<OutputSink>
+    OutputSink::null() {
+        return std::unique_ptr<OutputSink>(new OutputSink(Target::Null, -1, false, 0));
+    }
+    bool
+    OutputSink::flush() {
+        return _buffer.drain();
+    }
+    std::string_view
+    OutputSink::contents() {
+        flush();
+        return _buffer.collected;
+    }
+    std::string
+    OutputSink::take() {
+        flush();
+        return std::exchange(_buffer.collected, { });
+    }
+} // end namespace Deception
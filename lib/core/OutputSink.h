@@ -0,0 +1,98 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_OUTPUTSINK_H
+#define DECEPTION_OUTPUTSINK_H
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+namespace Deception {
+    /**
+     * @brief Where an interpreter writes its output. Everything is collected in a large block and only handed to the
+     * target when the block fills up or the sink is flushed, so writing a line never costs a system call by itself.
+     */
+    class OutputSink {
+    public:
+        static constexpr std::size_t DefaultBufferSize = 64 * 1024;
+        enum class Target {
+            /// blocks are written to a file descriptor
+            FileDescriptor,
+            /// blocks are collected in memory, see contents
+            Memory,
+            /// everything is thrown away
+            Null,
+        };
+        /**
+         * @param fd The descriptor to write to
+         * @param closeWhenDone Close the descriptor when the sink is destroyed
+         */
+        static std::unique_ptr<OutputSink> fileDescriptor(int fd, bool closeWhenDone = false, std::size_t bufferSize = DefaultBufferSize);
+        static std::unique_ptr<OutputSink> memory(std::size_t bufferSize = DefaultBufferSize);
+        static std::unique_ptr<OutputSink> null();
+        OutputSink(const OutputSink&) = delete;
+        OutputSink& operator=(const OutputSink&) = delete;
+        /**
+         * Anything still buffered is flushed
+         */
+        ~OutputSink();
+        [[nodiscard]] std::ostream& stream() noexcept { return _stream; }
+        /**
+         * Hand everything buffered to the target
+         * @return false if writing to a file descriptor failed, the buffered output is dropped in that case
+         */
+        bool flush();
+        [[nodiscard]] constexpr Target target() const noexcept { return _buffer.target; }
+        /**
+         * Everything written to a memory sink so far, this flushes first. Always empty for the other targets.
+         */
+        [[nodiscard]] std::string_view contents();
+        /**
+         * Take everything written to a memory sink so far and start over with an empty one
+         */
+        [[nodiscard]] std::string take();
+    private:
+        OutputSink(Target target, int fd, bool closeWhenDone, std::size_t bufferSize);
+        struct Buffer : std::streambuf {
+            Buffer(Target target, int fd, bool closeWhenDone, std::size_t size);
+            ~Buffer() override;
+            bool drain();
+            int_type overflow(int_type c) override;
+            std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+            int sync() override { return drain() ? 0 : -1; }
+            Target target;
+            int fd;
+            bool closeWhenDone;
+            std::size_t size;
+            std::unique_ptr<char[]> storage;
+            std::string collected;
+        };
+    private:
+        Buffer _buffer;
+        std::ostream _stream;
+    };
+} // end namespace Deception
+#endif //DECEPTION_OUTPUTSINK_H
@@ -0,0 +1,107 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Scan.h>
+#include <algorithm>
+#include <cstring>
+// SSE2 is always there on x86-64, 32-bit x86 is left on the portable path since it may not have it
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define DECEPTION_SCAN_X86_64
+#endif
+
+namespace Deception {
+    namespace {
+        // the number of bytes compared against each block before a plain search is cheaper
+        constexpr std::size_t MaxVectorSet = 4;
+        const char*
+        scalarFindFirstOf(const char* begin, const char* end, std::string_view set) noexcept {
+            return std::find_first_of(begin, end, set.begin(), set.end());
+        }
+#ifdef DECEPTION_SCAN_X86_64
+        __attribute__((target("sse2")))
+        const char*
+        sse2FindFirstOf(const char* begin, const char* end, std::string_view set) noexcept {
+            __m128i needles[MaxVectorSet];
+            for (std::size_t i = 0; i < set.size(); ++i) {
+                needles[i] = _mm_set1_epi8(set[i]);
+            }
+            for (; end - begin >= 16; begin += 16) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                auto hits = _mm_cmpeq_epi8(block, needles[0]);
+                for (std::size_t i = 1; i < set.size(); ++i) {
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i]));
+                }
+                if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits)); mask != 0) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+            return scalarFindFirstOf(begin, end, set);
+        }
+        __attribute__((target("avx2")))
+        const char*
+        avx2FindFirstOf(const char* begin, const char* end, std::string_view set) noexcept {
+            __m256i needles[MaxVectorSet];
+            for (std::size_t i = 0; i < set.size(); ++i) {
+                needles[i] = _mm256_set1_epi8(set[i]);
+            }
+            for (; end - begin >= 32; begin += 32) {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                auto hits = _mm256_cmpeq_epi8(block, needles[0]);
+                for (std::size_t i = 1; i < set.size(); ++i) {
+                    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+                }
+                if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)); mask != 0) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+            return sse2FindFirstOf(begin, end, set);
+        }
+        using Scanner = const char* (*)(const char*, const char*, std::string_view) noexcept;
+        Scanner
+        pickScanner() noexcept {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? avx2FindFirstOf : sse2FindFirstOf;
+        }
+#endif
+    } // end namespace
+    const char*
+    findFirstOf(const char* begin, const char* end, std::string_view set) noexcept {
+        if (begin == end || set.empty()) {
+            return end;
+        }
+        if (set.size() == 1) {
+            auto result = std::memchr(begin, static_cast<unsigned char>(set.front()), static_cast<std::size_t>(end - begin));
+            return result ? static_cast<const char*>(result) : end;
+        }
+#ifdef DECEPTION_SCAN_X86_64
+        if (set.size() <= MaxVectorSet) {
+            static const Scanner scanner = pickScanner();
+            return scanner(begin, end, set);
+        }
+#endif
+        return scalarFindFirstOf(begin, end, set);
+    }
+} // end namespace Deception
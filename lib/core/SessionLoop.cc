@@ -0,0 +1,120 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/SessionLoop.h>
+#ifdef __linux__
+#include <array>
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Deception {
+    SessionLoop::SessionLoop() : _epoll(::epoll_create1(EPOLL_CLOEXEC)), _buffer(std::make_unique_for_overwrite<char[]>(ReadSize)) {
+        if (_epoll < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+    }
+    SessionLoop::~SessionLoop() {
+        for (auto& [id, session] : _sessions) {
+            if (session.closeWhenDone) {
+                ::close(session.fd);
+            }
+        }
+        ::close(_epoll);
+    }
+    SessionLoop::SessionId
+    SessionLoop::add(int fd, std::unique_ptr<Interpreter> interpreter, bool closeWhenDone) {
+        if (auto flags = ::fcntl(fd, F_GETFL); flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            throw std::system_error(errno, std::generic_category(), "fcntl");
+        }
+        auto id = _nextId++;
+        epoll_event event { };
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = id;
+        if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+        }
+        _sessions.emplace(id, Session { fd, closeWhenDone, std::move(interpreter) });
+        return id;
+    }
+    std::size_t
+    SessionLoop::poll(int timeout) {
+        std::array<epoll_event, 256> events;
+        auto count = ::epoll_wait(_epoll, events.data(), static_cast<int>(events.size()), timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                return 0;
+            }
+            throw std::system_error(errno, std::generic_category(), "epoll_wait");
+        }
+        for (int i = 0; i < count; ++i) {
+            auto id = static_cast<SessionId>(events[i].data.u64);
+            if (auto session = _sessions.find(id); session != _sessions.end() && !service(session->second)) {
+                finish(id);
+            }
+        }
+        return static_cast<std::size_t>(count);
+    }
+    void
+    SessionLoop::run() {
+        while (!empty()) {
+            poll();
+        }
+    }
+    bool
+    SessionLoop::service(Session& session) {
+        auto& interpreter = *session.interpreter;
+        // a single read per wakeup bounds what is buffered and keeps one busy session from starving the others, epoll
+        // is level triggered so a descriptor with more waiting is reported again on the next poll
+        while (true) {
+            if (auto amount = ::read(session.fd, _buffer.get(), ReadSize); amount > 0) {
+                interpreter.feed({ _buffer.get(), static_cast<std::size_t>(amount) });
+            } else if (amount == 0) {
+                // the other end hung up, finish off whatever was sent
+                interpreter.closeInput();
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                interpreter.closeInput();
+            }
+            break;
+        }
+        return interpreter.runAvailable() == Interpreter::RunState::NeedsInput;
+    }
+    void
+    SessionLoop::finish(SessionId id) {
+        auto session = _sessions.extract(id);
+        ::epoll_ctl(_epoll, EPOLL_CTL_DEL, session.mapped().fd, nullptr);
+        if (session.mapped().closeWhenDone) {
+            ::close(session.mapped().fd);
+        }
+        if (_onFinished) {
+            _onFinished(id, *session.mapped().interpreter);
+        }
+    }
+} // end namespace Deception
+#endif
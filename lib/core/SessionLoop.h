@@ -0,0 +1,99 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_SESSIONLOOP_H
+#define DECEPTION_SESSIONLOOP_H
+#ifdef __linux__
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <core/Interpreter.h>
+namespace Deception {
+    /**
+     * @brief Drives many interpreters from a single thread. Each session reads from a file descriptor (a pipe, a
+     * pty, a socket) which is watched with epoll. Each time a session has input at most ReadSize bytes of it are fed
+     * to the session's interpreter, which then runs until it needs more. A session ends when its interpreter
+     * terminates or the other end of its descriptor is closed.
+     */
+    class SessionLoop {
+    public:
+        using SessionId = std::size_t;
+        using FinishedFunction = std::function<void(SessionId, Interpreter&)>;
+        static constexpr std::size_t ReadSize = 64 * 1024;
+        /**
+         * @throws std::system_error if the epoll instance cannot be created
+         */
+        SessionLoop();
+        SessionLoop(const SessionLoop&) = delete;
+        SessionLoop& operator=(const SessionLoop&) = delete;
+        ~SessionLoop();
+        /**
+         * Start watching a descriptor, it is switched to non blocking mode
+         * @param fd The descriptor to read from
+         * @param interpreter The interpreter to feed, it should already be using its starting table
+         * @param closeWhenDone Close the descriptor when the session ends
+         * @return The id of the new session
+         * @throws std::system_error if the descriptor cannot be watched
+         */
+        SessionId add(int fd, std::unique_ptr<Interpreter> interpreter, bool closeWhenDone = true);
+        /**
+         * Called with the interpreter of each session as it ends, just before it is destroyed
+         */
+        void onFinished(FinishedFunction fn) { _onFinished = std::move(fn); }
+        /**
+         * Wait for input and service every session which has some
+         * @param timeout Milliseconds to wait, -1 waits until something happens
+         * @return The number of sessions serviced
+         */
+        std::size_t poll(int timeout = -1);
+        /**
+         * Keep polling until every session has ended
+         */
+        void run();
+        [[nodiscard]] std::size_t size() const noexcept { return _sessions.size(); }
+        [[nodiscard]] bool empty() const noexcept { return _sessions.empty(); }
+    private:
+        struct Session {
+            int fd;
+            bool closeWhenDone;
+            std::unique_ptr<Interpreter> interpreter;
+        };
+        /**
+         * Read up to ReadSize bytes and run the interpreter over them
+         * @return false if the session has ended
+         */
+        bool service(Session& session);
+        void finish(SessionId id);
+    private:
+        int _epoll = -1;
+        SessionId _nextId = 0;
+        std::unordered_map<SessionId, Session> _sessions;
+        FinishedFunction _onFinished;
+        std::unique_ptr<char[]> _buffer;
+    };
+} // end namespace Deception
+#endif
+#endif //DECEPTION_SESSIONLOOP_H
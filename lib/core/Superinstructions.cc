@@ -0,0 +1,119 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Superinstructions.h>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+namespace Deception {
+    PairProfile::Count
+    PairProfile::count(TableHandle table, char first, char second) const noexcept {
+        if (auto result = _counts.find(key(table, first, second)); result != _counts.end()) {
+            return result->second;
+        }
+        return 0;
+    }
+    void
+    PairProfile::merge(const PairProfile& other) {
+        for (const auto& [pair, count] : other._counts) {
+            _counts[pair] += count;
+        }
+    }
+    std::vector<PairProfile::Pair>
+    PairProfile::hottest(std::size_t limit, Count minimum) const {
+        std::vector<Pair> result;
+        for (const auto& [pair, count] : _counts) {
+            if (count >= minimum) {
+                result.push_back({static_cast<TableHandle>(pair >> 16), static_cast<char>((pair >> 8) & 0xFF), static_cast<char>(pair & 0xFF), count});
+            }
+        }
+        // ties are broken by the pair itself so the same profile always fuses the same pairs
+        std::sort(result.begin(), result.end(), [](const Pair& a, const Pair& b) {
+            if (a.count != b.count) {
+                return a.count > b.count;
+            }
+            return key(a.table, a.first, a.second) < key(b.table, b.first, b.second);
+        });
+        if (result.size() > limit) {
+            result.resize(limit);
+        }
+        return result;
+    }
+    void
+    PairProfile::write(std::ostream& out) const {
+        static constexpr char digits[] = "0123456789abcdef";
+        auto hex = [](char c) {
+            auto value = static_cast<unsigned char>(c);
+            return std::string { digits[value >> 4], digits[value & 0xF] };
+        };
+        out << "# table first second count\n";
+        for (const auto& pair : hottest(_counts.size())) {
+            out << pair.table << ' ' << hex(pair.first) << ' ' << hex(pair.second) << ' ' << pair.count << '\n';
+        }
+    }
+    std::optional<PairProfile>
+    PairProfile::read(std::istream& in) {
+        PairProfile result;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line.front() == '#') {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string table, first, second, count;
+            if (!(fields >> table >> first >> second >> count)) {
+                return std::nullopt;
+            }
+            auto parse = [](const std::string& text, auto& value, int base) {
+                auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+                return error == std::errc{} && end == text.data() + text.size();
+            };
+            TableHandle handle = 0;
+            unsigned int a = 0, b = 0;
+            Count amount = 0;
+            if (!parse(table, handle, 10) || !parse(first, a, 16) || !parse(second, b, 16) || !parse(count, amount, 10) || a > 0xFF || b > 0xFF) {
+                return std::nullopt;
+            }
+            result._counts[key(handle, static_cast<char>(a), static_cast<char>(b))] += amount;
+        }
+        return result;
+    }
+    bool
+    PairProfile::save(const std::string& path) const {
+        std::ofstream out(path);
+        write(out);
+        return static_cast<bool>(out.flush());
+    }
+    std::optional<PairProfile>
+    PairProfile::load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            return std::nullopt;
+        }
+        return read(in);
+    }
+} // end namespace Deception
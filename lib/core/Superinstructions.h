@@ -0,0 +1,162 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_SUPERINSTRUCTIONS_H
+#define DECEPTION_SUPERINSTRUCTIONS_H
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <core/Conclave.h>
+#include <core/ThreadedCode.h>
+namespace Deception {
+    /**
+     * @brief How often each pair of characters was dispatched back to back from the same input source, keyed by the
+     * table the first character was dispatched in. This is what decides which pairs are worth fusing.
+     */
+    class PairProfile {
+    public:
+        using Count = std::uint64_t;
+        struct Pair {
+            TableHandle table;
+            char first;
+            char second;
+            Count count;
+        };
+        void record(TableHandle table, char first, char second) { ++_counts[key(table, first, second)]; }
+        [[nodiscard]] Count count(TableHandle table, char first, char second) const noexcept;
+        [[nodiscard]] bool empty() const noexcept { return _counts.empty(); }
+        [[nodiscard]] std::size_t size() const noexcept { return _counts.size(); }
+        void reset() noexcept { _counts.clear(); }
+        /**
+         * Add the counts of another profile to this one
+         */
+        void merge(const PairProfile& other);
+        /**
+         * @param limit The most pairs to return
+         * @param minimum Pairs seen fewer times than this are left out
+         * @return The most frequent pairs, most frequent first
+         */
+        [[nodiscard]] std::vector<Pair> hottest(std::size_t limit, Count minimum = 1) const;
+        /**
+         * Write the profile as text, one "table first second count" line per pair with the characters in hex
+         */
+        void write(std::ostream& out) const;
+        /**
+         * Read a profile written by write, blank lines and lines starting with # are skipped
+         * @return std::nullopt if a line is malformed
+         */
+        static std::optional<PairProfile> read(std::istream& in);
+        bool save(const std::string& path) const;
+        static std::optional<PairProfile> load(const std::string& path);
+    private:
+        static constexpr std::uint64_t key(TableHandle table, char first, char second) noexcept {
+            return (static_cast<std::uint64_t>(table) << 16) | (static_cast<std::uint64_t>(static_cast<unsigned char>(first)) << 8) | static_cast<unsigned char>(second);
+        }
+    private:
+        std::unordered_map<std::uint64_t, Count> _counts;
+    };
+    /**
+     * @brief Character pairs which are dispatched together. The first character is looked up once per table
+     * generation just like a ThreadedRoutine step, and so is the second one for each table it has been seen in.
+     * Whoever runs the pair is responsible for checking that the second character really is the next one to be
+     * dispatched.
+     * @tparam Interpreter The interpreter type the pairs run on
+     */
+    template<typename Interpreter>
+    class FusedPairs {
+    public:
+        using Step = typename ThreadedRoutine<Interpreter>::Step;
+        struct Second {
+            char character;
+            Step step;
+        };
+        struct Fused {
+            Step first;
+            std::vector<Second> seconds;
+            Step* find(char c) noexcept {
+                for (auto& second : seconds) {
+                    if (second.character == c) {
+                        return &second.step;
+                    }
+                }
+                return nullptr;
+            }
+        };
+        FusedPairs() = default;
+        FusedPairs(const FusedPairs& other) : _tables(other._tables.size()), _size(other._size) {
+            for (std::size_t table = 0; table < other._tables.size(); ++table) {
+                for (std::size_t first = 0; first < 0x100; ++first) {
+                    if (const auto& fused = other._tables[table][first]; fused) {
+                        _tables[table][first] = std::make_unique<Fused>(*fused);
+                    }
+                }
+            }
+        }
+        FusedPairs(FusedPairs&&) noexcept = default;
+        FusedPairs& operator=(FusedPairs&&) noexcept = default;
+        FusedPairs& operator=(const FusedPairs& other) {
+            if (this != &other) {
+                *this = FusedPairs { other };
+            }
+            return *this;
+        }
+        void add(TableHandle table, char first, char second) {
+            if (table >= _tables.size()) {
+                _tables.resize(table + 1);
+            }
+            auto& fused = _tables[table][static_cast<unsigned char>(first)];
+            if (!fused) {
+                fused = std::make_unique<Fused>();
+            }
+            if (!fused->find(second)) {
+                fused->seconds.push_back({second, { }});
+                ++_size;
+            }
+        }
+        /**
+         * @return The pairs starting with the given character in the given table or nullptr if there are none
+         */
+        Fused* find(TableHandle table, char first) noexcept {
+            return table < _tables.size() ? _tables[table][static_cast<unsigned char>(first)].get() : nullptr;
+        }
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+        [[nodiscard]] std::size_t size() const noexcept { return _size; }
+        void clear() noexcept {
+            _tables.clear();
+            _size = 0;
+        }
+    private:
+        // indexed by table handle then by first character so finding a pair never has to hash anything
+        std::vector<std::array<std::unique_ptr<Fused>, 0x100>> _tables;
+        std::size_t _size = 0;
+    };
+} // end namespace Deception
+#endif //DECEPTION_SUPERINSTRUCTIONS_H
@@ -26,10 +26,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef DECEPTION_TABLE_H
 #define DECEPTION_TABLE_H
 #include <map>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <optional>
 namespace Deception {
@@ -37,12 +41,36 @@ namespace Deception {
     struct GenericTable {
         using ExecutionBody = std::function<void(Interpreter& self, char character)>;
         using LookupResult = std::optional<ExecutionBody>;
+        using ExecutionBodyReference = const ExecutionBody*;
         using SharedPtr = std::shared_ptr<GenericTable<Interpreter>>;
         GenericTable() = default;
+        // a copy is a different table as far as anything caching lookups is concerned
+        GenericTable(const GenericTable&) : _generation(nextGeneration()) { }
+        GenericTable(GenericTable&&) noexcept : _generation(nextGeneration()) { }
         virtual ~GenericTable() = default;
-        virtual LookupResult lookup(char c) = 0;
+        /**
+         * Find the action associated with the given character without copying it
+         * @param c The character to look up
+         * @return A non-owning pointer to the action (owned by the table) or nullptr if there is no entry
+         */
+        virtual ExecutionBodyReference resolve(char c) noexcept = 0;
+        /**
+         * Copying version of resolve, prefer resolve or run on any hot path since this copies the std::function
+         */
+        LookupResult lookup(char c) {
+            if (auto result = resolve(c); result) {
+                return *result;
+            } else {
+                return std::nullopt;
+            }
+        }
+        [[nodiscard]] bool hasEntry(char c) noexcept { return resolve(c) != nullptr; }
+        /**
+         * Dispatch a single character. Overrides must behave the same as invoking resolve(c) and falling back to
+         * defaultImplementation, anything caching resolved actions (ThreadedRoutine) relies on it.
+         */
         virtual void run(char c, Interpreter& interpreter) {
-            if (auto result = lookup(c); result) {
+            if (auto result = resolve(c); result) {
                 (*result)(interpreter, c);
             } else {
                 defaultImplementation(interpreter, c);
@@ -52,6 +80,40 @@ namespace Deception {
         virtual void enterTable(Interpreter&) { }
         virtual void leaveTable(Interpreter&) { }
         virtual void defaultImplementation(Interpreter&, char) { }
+        /**
+         * Tables which do nothing interesting for most characters can list the few characters they have entries for.
+         * The interpreter then finds the next one of those in the buffered input itself and passes everything before
+         * it to consumeSpan in one call instead of dispatching each character. The result must not change over the
+         * lifetime of the table.
+         * @return The characters which have entries in this table or an empty view if every character must be
+         * dispatched through run
+         */
+        [[nodiscard]] virtual std::string_view terminators() const noexcept { return { }; }
+        /**
+         * Handle a run of characters, none of which are terminators. This must behave the same as calling run on each
+         * character in order.
+         */
+        virtual void consumeSpan(Interpreter& interpreter, std::string_view span) {
+            for (auto c : span) {
+                run(c, interpreter);
+            }
+        }
+        /**
+         * Identifies the current contents of this table, it changes whenever an entry is added so that anything
+         * holding onto the result of resolve knows it has to look the character up again. No two tables ever share a
+         * generation.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept { return _generation; }
+        /**
+         * Mark the contents of this table as changed, call this after modifying entries in place through an iterator
+         */
+        void invalidate() noexcept { _generation = nextGeneration(); }
+    private:
+        static std::uint64_t nextGeneration() noexcept {
+            static std::atomic<std::uint64_t> counter { 0 };
+            return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+        std::uint64_t _generation = nextGeneration();
     };
     template<typename Interpreter>
     class Table : public GenericTable<Interpreter> {
@@ -79,16 +141,17 @@ namespace Deception {
         decltype(auto) begin() const noexcept { return _table.begin(); }
         decltype(auto) find(char value) noexcept { return _table.find(value); }
         decltype(auto) find(char value) const noexcept { return _table.find(value); }
-        LookupResult lookup(char c) override {
+        typename Parent::ExecutionBodyReference resolve(char c) noexcept override {
             if (auto result = find(c);  result != end()) {
-                return result->second;
+                return &result->second;
             } else {
-                return std::nullopt;
+                return nullptr;
             }
         }
 
         template<typename ... Ts>
         decltype(auto) emplace(Ts&&... args) noexcept {
+            this->invalidate();
             return _table.emplace(args...);
         }
         void enterTable(Interpreter& interpreter) override {
@@ -106,44 +169,184 @@ namespace Deception {
         TableEnterFunction _onLeave = emptyEnterExitFunction;
         ExecutionBody _fallback = fallbackNothing;
     };
+    /**
+     * @brief A table which stores all 256 entries in a single flat array so that a lookup is a single indexed load
+     * instead of a walk through a std::map. Construction and the enter/leave/fallback hooks mirror Table.
+     */
     template<typename Interpreter>
-    struct StringConstructionTable : public GenericTable<Interpreter> {
-        using Parent = Deception::Table<Interpreter>;
+    class DenseTable : public GenericTable<Interpreter> {
+    public:
+        using Parent = GenericTable<Interpreter>;
+        using ExecutionBody = Parent::ExecutionBody;
         using LookupResult = Parent::LookupResult;
+        using TableEnterFunction = std::function<void(Interpreter&)>;
+        using TableExitFunction = std::function<void(Interpreter&)>;
+        using DispatchTable = std::array<ExecutionBody, 0x100>;
+        using SharedPtr = std::shared_ptr<DenseTable<Interpreter>>;
+        using InitializerList = typename Table<Interpreter>::InitializerList;
+    private:
+        static void fallbackNothing(Interpreter&, char) { }
+        static void emptyEnterExitFunction(Interpreter&) {}
+        static constexpr std::size_t toIndex(char c) noexcept { return static_cast<unsigned char>(c); }
+    public:
+        DenseTable() = default;
+        DenseTable(InitializerList items, TableEnterFunction onEnter = emptyEnterExitFunction, TableExitFunction onLeave = emptyEnterExitFunction, ExecutionBody defaultState = fallbackNothing) : _onEnter(onEnter), _onLeave(onLeave), _fallback(defaultState) {
+            for (const auto& [code, body] : items) {
+                emplace(code, body);
+            }
+        }
+        DenseTable(const DenseTable& other) = default;
+        DenseTable(DenseTable&& other) = default;
+        ~DenseTable() override = default;
+        [[nodiscard]] bool contains(char c) const noexcept { return static_cast<bool>(_table[toIndex(c)]); }
+        typename Parent::ExecutionBodyReference resolve(char c) noexcept override {
+            if (const auto& result = _table[toIndex(c)]; result) {
+                return &result;
+            } else {
+                return nullptr;
+            }
+        }
+        /**
+         * Install an action for the given character if one is not already present (same semantics as std::map::emplace)
+         * @return true if the action was installed
+         */
+        bool emplace(char c, ExecutionBody body) {
+            if (contains(c)) {
+                return false;
+            }
+            _table[toIndex(c)] = std::move(body);
+            this->invalidate();
+            return true;
+        }
+        void enterTable(Interpreter& interpreter) override {
+            _onEnter(interpreter);
+        }
+        void leaveTable(Interpreter& interpreter) override {
+            _onLeave(interpreter);
+        }
+        void defaultImplementation(Interpreter& interpreter, char c) override {
+            _fallback(interpreter, c);
+        }
+    private:
+        alignas(64) DispatchTable _table;
+        TableEnterFunction _onEnter = emptyEnterExitFunction;
+        TableExitFunction _onLeave = emptyEnterExitFunction;
+        ExecutionBody _fallback = fallbackNothing;
+    };
+    /**
+     * @brief A single entry of a StaticTable which binds a character to an action known at compile time
+     * @tparam Code The character which triggers the action
+     * @tparam Action A function pointer or stateless lambda which is invoked as Action(interpreter, character)
+     */
+    template<char Code, auto Action>
+    struct StaticEntry {
+        static constexpr char code = Code;
+        static constexpr auto action = Action;
+    };
+    /**
+     * @brief A table whose entries are fixed when the binary is compiled. Dispatch is a fold over the entries which the
+     * compiler lowers into a switch with every action inlined, so there is no std::function type erasure on the hot
+     * path. It is still a GenericTable so it can live in a Conclave and on the execution stack next to dynamic tables.
+     * @tparam Interpreter The interpreter type the actions operate on
+     * @tparam Entries A set of StaticEntry types, each character may only appear once
+     */
+    template<typename Interpreter, typename ... Entries>
+    class StaticTable : public GenericTable<Interpreter> {
+    public:
+        using Parent = GenericTable<Interpreter>;
+        using ExecutionBody = Parent::ExecutionBody;
+        using SharedPtr = std::shared_ptr<StaticTable<Interpreter, Entries...>>;
+    private:
+        static constexpr std::size_t toIndex(char c) noexcept { return static_cast<unsigned char>(c); }
+        static constexpr auto makeSlots() noexcept {
+            // zero means no entry, otherwise it is the index of the entry plus one
+            std::array<std::size_t, 0x100> slots { };
+            std::size_t index = 0;
+            ((slots[toIndex(Entries::code)] = ++index), ...);
+            return slots;
+        }
+        static constexpr bool uniqueCodes() noexcept {
+            std::array<bool, 0x100> seen { };
+            bool unique = true;
+            ((unique = unique && !seen[toIndex(Entries::code)], seen[toIndex(Entries::code)] = true), ...);
+            return unique;
+        }
+        static_assert(uniqueCodes(), "A character can only be bound once in a StaticTable");
+        static constexpr auto slots = makeSlots();
+        // only used by resolve, these are built once instead of on every lookup
+        static inline const std::array<ExecutionBody, sizeof...(Entries)> bodies { ExecutionBody { Entries::action }... };
+    public:
+        StaticTable() = default;
+        ~StaticTable() override = default;
+        [[nodiscard]] static constexpr bool contains(char c) noexcept { return slots[toIndex(c)] != 0; }
+        /**
+         * Invoke the action bound to the given character directly, this does not go through any virtual calls
+         * @return true if an entry handled the character, false if the caller needs to fall back
+         */
+        static bool dispatch(Interpreter& interpreter, char c) {
+            return ((c == Entries::code ? (Entries::action(interpreter, c), true) : false) || ...);
+        }
+        typename Parent::ExecutionBodyReference resolve(char c) noexcept override {
+            if (auto slot = slots[toIndex(c)]; slot != 0) {
+                return &bodies[slot - 1];
+            } else {
+                return nullptr;
+            }
+        }
+        void run(char c, Interpreter& interpreter) final {
+            if (!dispatch(interpreter, c)) {
+                this->defaultImplementation(interpreter, c);
+            }
+        }
+    };
+    template<typename Interpreter>
+    struct StringConstructionTable : public GenericTable<Interpreter> {
+        using Parent = GenericTable<Interpreter>;
+        using ExecutionBody = Parent::ExecutionBody;
         explicit StringConstructionTable(char terminatorSymbol) : _terminatorChar(terminatorSymbol) { }
         ~StringConstructionTable() override = default;
         void enterTable(Interpreter& interpreter) override { interpreter.clearOutputStream(); }
         void leaveTable(Interpreter& interpreter) override { interpreter.moveOutputToStack(); }
         void defaultImplementation(Interpreter& interpreter, char c) override { interpreter.putIntoOutputStream(c); }
 
-        LookupResult lookup(char c) override {
-            if (c == _terminatorChar)  {
-                return [](Interpreter& interpreter, char) { interpreter.restore(); };
+        typename Parent::ExecutionBodyReference resolve(char c) noexcept override {
+            return c == _terminatorChar ? &restoreAction : nullptr;
+        }
+        void run(char c, Interpreter& interpreter) override {
+            if (c == _terminatorChar) {
+                interpreter.restore();
             } else {
-                return std::nullopt;
+                defaultImplementation(interpreter, c);
             }
         }
+        [[nodiscard]] std::string_view terminators() const noexcept override { return { &_terminatorChar, 1 }; }
+        void consumeSpan(Interpreter& interpreter, std::string_view span) override { interpreter.borrowIntoOutputStream(span); }
         [[nodiscard]] constexpr auto getTerminatorChar() const noexcept { return _terminatorChar; }
 
     private:
+        static inline const ExecutionBody restoreAction { [](Interpreter& interpreter, char) { interpreter.restore(); } };
         char _terminatorChar;
     };
     template<typename Interpreter>
     struct DropCharactersUntil : public GenericTable<Interpreter> {
         using Parent = GenericTable<Interpreter>;
+        using ExecutionBody = Parent::ExecutionBody;
         explicit DropCharactersUntil(char until) : _terminatorChar(until) { }
 
-        Parent::LookupResult lookup(char c) override {
+        typename Parent::ExecutionBodyReference resolve(char c) noexcept override {
+            return c == _terminatorChar ? &restoreAction : nullptr;
+        }
+        void run(char c, Interpreter& interpreter) override {
             if (c == _terminatorChar) {
-                return [](Interpreter& i, char) {
-                    i.restore();
-                };
-            } else {
-                return std::nullopt;
+                interpreter.restore();
             }
         }
+        [[nodiscard]] std::string_view terminators() const noexcept override { return { &_terminatorChar, 1 }; }
+        void consumeSpan(Interpreter&, std::string_view) override { }
+        [[nodiscard]] constexpr auto getTerminatorChar() const noexcept { return _terminatorChar; }
 
     private:
+        static inline const ExecutionBody restoreAction { [](Interpreter& i, char) { i.restore(); } };
         char _terminatorChar;
     };
 } // end namespace Deception
@@ -0,0 +1,100 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_THREADEDCODE_H
+#define DECEPTION_THREADEDCODE_H
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <core/Table.h>
+namespace Deception {
+    /**
+     * @brief A character sequence compiled into direct threaded code. Each character remembers the table that was
+     * current when it was dispatched and the action that table resolved it to, so running the routine again calls
+     * those actions directly instead of going through the input stream and a table lookup. A step is only reused
+     * while the same table is current and that table has not changed (see GenericTable::generation), otherwise the
+     * character is looked up again and the step is recompiled, which keeps table switches inside the routine correct.
+     * @tparam Interpreter The interpreter type the routine runs on
+     */
+    template<typename Interpreter>
+    class ThreadedRoutine {
+    public:
+        using Table = GenericTable<Interpreter>;
+        using ExecutionBodyReference = typename Table::ExecutionBodyReference;
+        struct Step {
+            const Table* table = nullptr;
+            std::uint64_t generation = 0;
+            /// nullptr means the table's default implementation handles the character
+            ExecutionBodyReference body = nullptr;
+            [[nodiscard]] bool matches(const Table* current) const noexcept { return current && table == current && generation == current->generation(); }
+            /**
+             * Resolve the character again if the step was compiled for a different table or an older generation
+             * @return true if the step had to be recompiled
+             */
+            bool refresh(Table* current, char c) noexcept {
+                if (matches(current)) {
+                    return false;
+                }
+                table = current;
+                generation = current->generation();
+                body = current->resolve(c);
+                return true;
+            }
+        };
+        explicit ThreadedRoutine(std::string_view code) : _code(code), _steps(code.size()) { }
+        [[nodiscard]] const std::string& code() const noexcept { return _code; }
+        [[nodiscard]] std::size_t size() const noexcept { return _code.size(); }
+        [[nodiscard]] char character(std::size_t index) const noexcept { return _code[index]; }
+        /**
+         * Get the compiled step for the given character, recompiling it if the current table does not match
+         * @param index The position in the routine
+         * @param current The table that is current right now
+         */
+        const Step& step(std::size_t index, Table* current) noexcept {
+            auto& result = _steps[index];
+            if (result.refresh(current, _code[index])) {
+                ++_compilations;
+            }
+            return result;
+        }
+        /**
+         * Forget everything that has been compiled so far
+         */
+        void invalidate() noexcept {
+            std::fill(_steps.begin(), _steps.end(), Step { });
+        }
+        /**
+         * @return The number of steps which have been compiled (including recompilations) over the life of the routine
+         */
+        [[nodiscard]] std::uint64_t compilations() const noexcept { return _compilations; }
+    private:
+        std::string _code;
+        std::vector<Step> _steps;
+        std::uint64_t _compilations = 0;
+    };
+} // end namespace Deception
+#endif //DECEPTION_THREADEDCODE_H
@@ -0,0 +1,85 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <core/Value.h>
+#include <new>
+
+namespace Deception {
+    SharedString*
+    SharedString::make(std::string_view str) {
+        // the characters live directly after the header so a shared string is a single allocation
+        void* storage = ::operator new(sizeof(SharedString) + str.size());
+        auto* result = new (storage) SharedString(str.size());
+        std::memcpy(static_cast<char*>(storage) + sizeof(SharedString), str.data(), str.size());
+        return result;
+    }
+    void
+    SharedString::destroy(SharedString* str) noexcept {
+        str->~SharedString();
+        ::operator delete(str);
+    }
+    Value::Value(std::string_view str) {
+        if (str.size() <= InlineStringCapacity) {
+            std::memcpy(_bytes.data(), str.data(), str.size());
+            _bytes[TagIndex] = static_cast<char>(static_cast<std::uint8_t>(Kind::String) | static_cast<std::uint8_t>(str.size() << 4));
+        } else {
+            store(SharedString::make(str), Kind::String);
+            _bytes[TagIndex] = static_cast<char>(tag() | SharedFlag);
+        }
+    }
+    std::string_view
+    Value::asString() const noexcept {
+        if (isShared()) {
+            return load<const SharedString*>()->view();
+        } else {
+            return { _bytes.data(), static_cast<std::size_t>(tag() >> 4) };
+        }
+    }
+    ValueView
+    Value::view() const noexcept {
+        switch (kind()) {
+            case Kind::Integer: return asInteger();
+            case Kind::Ordinal: return asOrdinal();
+            case Kind::Character: return asCharacter();
+            case Kind::Boolean: return asBoolean();
+            default: return asString();
+        }
+    }
+    bool
+    Value::operator==(const Value& other) const noexcept {
+        if (kind() != other.kind()) {
+            return false;
+        }
+        switch (kind()) {
+            case Kind::Null: return true;
+            case Kind::String: return asString() == other.asString();
+            case Kind::Integer: return asInteger() == other.asInteger();
+            case Kind::Ordinal: return asOrdinal() == other.asOrdinal();
+            case Kind::Character: return asCharacter() == other.asCharacter();
+            case Kind::Boolean: return asBoolean() == other.asBoolean();
+            default: return false;
+        }
+    }
+} // end namespace Deception
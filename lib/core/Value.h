@@ -26,23 +26,28 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /*
  * This file contains the concept of a value which can be stashed into the an interpreter or whatever else we want.
  * When working with deception, we setup execution tables that perform an action and then stash the result back in
- * the interpreter. It is a stack like what one sees in forth but far more robust. It uses std::variant to make sure
- * that different kinds of types can be returned. It is also optional so that we can denote a failure as well
+ * the interpreter. It is a stack like what one sees in forth but far more robust. A value tags its type inline and
+ * dereferences into a std::variant so that different kinds of types can be returned. It can also be null so that we
+ * can denote a failure as well
  *
  */
 
 #ifndef DECEPTION_VALUE_H
 #define DECEPTION_VALUE_H
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 #include <variant>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <istream>
 #include <memory>
 #include <functional>
 #include <experimental/memory>
-#include <list>
 
 namespace Deception {
     using Integer = int64_t;
@@ -52,16 +57,155 @@ namespace Deception {
     using Boolean = bool;
     using SharedInputStream = std::shared_ptr<std::istream>;
     using ObservedInputStream = std::experimental::observer_ptr<std::istream>;
-    using InputStream = std::variant<SharedInputStream, ObservedInputStream>;
-    using InputStreamStack = std::list<InputStream>;
+    using SharedMappedFile = std::shared_ptr<class MappedFile>;
+    using InputStream = std::variant<SharedInputStream, ObservedInputStream, SharedMappedFile>;
     using StreamReadResult = std::optional<char>;
     /**
      * A given value that can be put into the stack as needed
      */
     using RawValue = std::variant<std::string, Integer, Ordinal, Character, Boolean>;
+    /**
+     * @brief A non-owning view of what a Value holds, this is what std::visit operates on when a Value is dereferenced
+     */
+    using ValueView = std::variant<std::string_view, Integer, Ordinal, Character, Boolean>;
+    /**
+     * @brief The storage of a string too long to be stored inline in a Value. It is shared between copies of the value
+     * holding it and released along with the last of them.
+     */
+    class SharedString {
+    public:
+        /**
+         * Make a new shared copy of the given string, the caller owns the single reference it starts out with
+         */
+        static SharedString* make(std::string_view str);
+        /**
+         * Drop a reference to the given string, freeing it if that was the last one
+         */
+        static void release(SharedString* str) noexcept {
+            if (str->_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                destroy(str);
+            }
+        }
+        void retain() noexcept { _references.fetch_add(1, std::memory_order_relaxed); }
+        [[nodiscard]] std::string_view view() const noexcept { return { reinterpret_cast<const char*>(this + 1), _size }; }
+    private:
+        explicit SharedString(std::size_t size) noexcept : _size(size) { }
+        static void destroy(SharedString* str) noexcept;
+    private:
+        std::atomic<std::uint32_t> _references { 1 };
+        std::size_t _size;
+    };
     /**
      * @brief a Value is a thing that can be null or contain a value, it is generally something that is pushed onto the interpreter stack in cases where that makes sense!
+     * It takes up 16 bytes and tags its type inline. Strings of up to 15 characters are stored inside the value
+     * itself, longer ones are held by reference in a SharedString so copying a value never copies the characters.
      */
-    using Value = std::optional<RawValue>;
+    class Value {
+    public:
+        enum class Kind : std::uint8_t {
+            Null,
+            String,
+            Integer,
+            Ordinal,
+            Character,
+            Boolean,
+        };
+        static constexpr std::size_t InlineStringCapacity = 15;
+    private:
+        // the last byte holds the kind in the low three bits, a flag marking shared strings and the length of an inline
+        // string in the high nibble
+        static constexpr std::size_t TagIndex = 15;
+        static constexpr std::uint8_t KindMask = 0x07;
+        static constexpr std::uint8_t SharedFlag = 0x08;
+        template<typename T>
+        static constexpr bool IsSignedNumber = std::is_integral_v<T> && std::is_signed_v<T> && !std::is_same_v<T, Character> && !std::is_same_v<T, Boolean>;
+        template<typename T>
+        static constexpr bool IsUnsignedNumber = std::is_integral_v<T> && std::is_unsigned_v<T> && !std::is_same_v<T, Character> && !std::is_same_v<T, Boolean>;
+    public:
+        constexpr Value() noexcept = default;
+        constexpr Value(std::nullopt_t) noexcept { }
+        Value(std::string_view str);
+        Value(const std::string& str) : Value(std::string_view{str}) { }
+        Value(const char* str) : Value(std::string_view{str}) { }
+        Value(Character c) noexcept { store(c, Kind::Character); }
+        Value(Boolean b) noexcept { store(b, Kind::Boolean); }
+        template<typename T>
+        requires IsSignedNumber<T>
+        Value(T value) noexcept { store(static_cast<Integer>(value), Kind::Integer); }
+        template<typename T>
+        requires IsUnsignedNumber<T>
+        Value(T value) noexcept { store(static_cast<Ordinal>(value), Kind::Ordinal); }
+        Value(const RawValue& value) : Value(std::visit([](auto&& v) { return Value(v); }, value)) { }
+        template<typename T>
+        Value(const std::optional<T>& value) : Value(value ? Value(*value) : Value()) { }
+        Value(const Value& other) noexcept : _bytes(other._bytes) { retain(); }
+        Value(Value&& other) noexcept : _bytes(other._bytes) { other._bytes = { }; }
+        ~Value() { release(); }
+        Value& operator=(const Value& other) noexcept {
+            other.retain();
+            release();
+            _bytes = other._bytes;
+            return *this;
+        }
+        Value& operator=(Value&& other) noexcept {
+            if (this != &other) {
+                release();
+                _bytes = other._bytes;
+                other._bytes = { };
+            }
+            return *this;
+        }
+        [[nodiscard]] constexpr Kind kind() const noexcept { return static_cast<Kind>(tag() & KindMask); }
+        [[nodiscard]] constexpr bool hasValue() const noexcept { return kind() != Kind::Null; }
+        [[nodiscard]] constexpr bool has_value() const noexcept { return hasValue(); }
+        constexpr explicit operator bool() const noexcept { return hasValue(); }
+        [[nodiscard]] constexpr bool isString() const noexcept { return kind() == Kind::String; }
+        [[nodiscard]] constexpr bool isInteger() const noexcept { return kind() == Kind::Integer; }
+        [[nodiscard]] constexpr bool isOrdinal() const noexcept { return kind() == Kind::Ordinal; }
+        [[nodiscard]] constexpr bool isCharacter() const noexcept { return kind() == Kind::Character; }
+        [[nodiscard]] constexpr bool isBoolean() const noexcept { return kind() == Kind::Boolean; }
+        /**
+         * @return the string held by this value, only valid if isString() is true. The view stays valid for as long as
+         * this value does (inline strings) or for as long as this value or a copy of it does (shared strings).
+         */
+        [[nodiscard]] std::string_view asString() const noexcept;
+        [[nodiscard]] Integer asInteger() const noexcept { return load<Integer>(); }
+        [[nodiscard]] Ordinal asOrdinal() const noexcept { return load<Ordinal>(); }
+        [[nodiscard]] Character asCharacter() const noexcept { return load<Character>(); }
+        [[nodiscard]] Boolean asBoolean() const noexcept { return load<Boolean>(); }
+        /**
+         * Turn this value into something std::visit can work with, the value must not be null
+         */
+        [[nodiscard]] ValueView view() const noexcept;
+        [[nodiscard]] ValueView operator*() const noexcept { return view(); }
+        bool operator==(const Value& other) const noexcept;
+    private:
+        template<typename T>
+        void store(T value, Kind kind) noexcept {
+            std::memcpy(_bytes.data(), &value, sizeof(T));
+            _bytes[TagIndex] = static_cast<char>(kind);
+        }
+        template<typename T>
+        [[nodiscard]] T load() const noexcept {
+            T value;
+            std::memcpy(&value, _bytes.data(), sizeof(T));
+            return value;
+        }
+        [[nodiscard]] constexpr std::uint8_t tag() const noexcept { return static_cast<std::uint8_t>(_bytes[TagIndex]); }
+        [[nodiscard]] constexpr bool isShared() const noexcept { return tag() & SharedFlag; }
+        void retain() const noexcept {
+            if (isShared()) {
+                load<SharedString*>()->retain();
+            }
+        }
+        void release() noexcept {
+            if (isShared()) {
+                SharedString::release(load<SharedString*>());
+            }
+        }
+    private:
+        alignas(8) std::array<char, 16> _bytes { };
+    };
+    static_assert(sizeof(Value) <= 16, "Value must stay compact");
 } // end namespace Deception
 #endif //DECEPTION_VALUE_H
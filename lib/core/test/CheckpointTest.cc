@@ -0,0 +1,63 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Branches started from a checkpoint must not read from the istream of the interpreter they were taken from
+#include <core/test/Differential.h>
+using namespace Deception;
+using namespace Deception::Testing;
+namespace {
+    std::string branchOutput;
+    void runBranch(Interpreter& interpreter, char) {
+        auto branch = interpreter.checkpoint()->fork();
+        branch.setOutputSink(OutputSink::memory());
+        branch.run();
+        branchOutput = branch.getOutputSink().take();
+    }
+    using BranchingTable = Interpreter::StaticTable<
+            Entry<'c', runBranch>,
+            Entry<'o', [](Interpreter& interpreter, char c) { interpreter.out() << c; }>
+    >;
+}
+int main() {
+    // the stream is longer than a block so the branch is taken while most of it is still unread
+    const std::string script = 'c' + std::string(InputSource::DefaultBlockSize + 100, 'o');
+    std::istringstream in { script };
+    Interpreter interpreter { Interpreter::snapshot({ Interpreter::Conclave::CustomInputEntry { "core", std::make_shared<BranchingTable>() } }),
+                              { std::experimental::make_observer<std::istream>(&in) } };
+    interpreter.setOutputSink(OutputSink::memory());
+    interpreter.use(TableHandle { 0 });
+    interpreter.run();
+    auto output = interpreter.getOutputSink().take();
+    bool passed = true;
+    if (output.size() != script.size() - 1) {
+        std::cerr << "the interpreter wrote " << output.size() << " characters instead of " << script.size() - 1 << '\n';
+        passed = false;
+    }
+    if (branchOutput.size() != InputSource::DefaultBlockSize - 1) {
+        std::cerr << "the branch wrote " << branchOutput.size() << " characters instead of the " << InputSource::DefaultBlockSize - 1 << " which were buffered\n";
+        passed = false;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DECEPTION_TEST_DIFFERENTIAL_H
+#define DECEPTION_TEST_DIFFERENTIAL_H
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <core/Interpreter.h>
+namespace Deception::Testing {
+    /**
+     * @brief Everything a script can be observed to do, two ways of running the same script must agree on all of it
+     */
+    struct Outcome {
+        std::string output;
+        std::string dataStack;
+        std::string trace;
+        bool operator==(const Outcome&) const = default;
+    };
+    template<char Code, auto Action>
+    using Entry = StaticEntry<Code, Action>;
+    enum : TableHandle { Comment, ReadString, Nested, Core };
+    constexpr char StartString = '\x98';
+    constexpr char EndString = '\x9c';
+    /**
+     * Switches tables, pushes input, pulls characters through next and writes output so that every way the run loop
+     * can be interrupted between two characters shows up in a random script
+     */
+    using CoreTable = Interpreter::StaticTable<
+            Entry<'#', [](Interpreter& interpreter, char) { interpreter.use(Comment); }>,
+            Entry<StartString, [](Interpreter& interpreter, char) { interpreter.use(ReadString); }>,
+            Entry<'[', [](Interpreter& interpreter, char) { interpreter.use(Nested); }>,
+            Entry<'p', [](Interpreter& interpreter, char) { interpreter.useInputStream(std::string("[a]")); }>,
+            Entry<'r', [](Interpreter& interpreter, char) {
+                if (auto c = interpreter.next(); c) {
+                    interpreter.pushElement(Character(*c));
+                }
+            }>,
+            Entry<'d', [](Interpreter& interpreter, char) { interpreter.getDataStack().clear(); }>,
+            Entry<'o', [](Interpreter& interpreter, char c) { interpreter.out() << c; }>,
+            Entry<'.', displayTopItemOnDataStack>
+    >;
+    inline void leaveNested(Interpreter& interpreter, char) { interpreter.restore(); }
+    class NestedTable : public Interpreter::StaticTable<Entry<']', leaveNested>> {
+    public:
+        void defaultImplementation(Interpreter& interpreter, char c) override { interpreter.out() << '<' << c << '>'; }
+    };
+    inline Interpreter::SharedConclave conclave() {
+        static const auto tables = Interpreter::snapshot({
+            Interpreter::Conclave::CustomInputEntry { "comment", std::make_shared<DropCharactersUntil<Interpreter>>('\n') },
+            Interpreter::Conclave::CustomInputEntry { "read-string", std::make_shared<StringConstructionTable<Interpreter>>(EndString) },
+            Interpreter::Conclave::CustomInputEntry { "nested", std::make_shared<NestedTable>() },
+            Interpreter::Conclave::CustomInputEntry { "core", std::make_shared<CoreTable>() },
+        });
+        return tables;
+    }
+    /**
+     * @return An interpreter in the core table which keeps its output and its whole trace
+     */
+    inline Interpreter makeInterpreter(std::initializer_list<Interpreter::StreamType> streams = { }) {
+        Interpreter interpreter { conclave(), streams };
+        interpreter.setOutputSink(OutputSink::memory());
+        interpreter.setTraceMode(TraceMode::Full);
+        interpreter.use(Core);
+        return interpreter;
+    }
+    /**
+     * Write out a range of values so that two data stacks can be compared as strings
+     */
+    template<typename Iterator>
+    std::string describe(Iterator begin, Iterator end) {
+        std::ostringstream out;
+        for (auto i = begin; i != end; ++i) {
+            if (*i) {
+                std::visit([&out](auto&& value) { out << value << ','; }, **i);
+            } else {
+                out << "null,";
+            }
+        }
+        return out.str();
+    }
+    inline Outcome capture(Interpreter& interpreter) {
+        Outcome result;
+        interpreter.flushOutput();
+        result.output = interpreter.getOutputSink().take();
+        result.dataStack = describe(interpreter.dataStackReverseBegin(), interpreter.dataStackReverseEnd());
+        std::ostringstream trace;
+        interpreter.disassembleTrace(trace);
+        result.trace = trace.str();
+        return result;
+    }
+    /**
+     * Feed the script in chunks of the given size, running whatever is available after each one
+     */
+    inline Outcome runFed(Interpreter& interpreter, std::string_view script, std::size_t chunk) {
+        for (std::size_t i = 0; i < script.size(); i += chunk) {
+            interpreter.feed(script.substr(i, chunk));
+            interpreter.runAvailable();
+        }
+        interpreter.closeInput();
+        interpreter.runAvailable();
+        return capture(interpreter);
+    }
+    constexpr std::string_view Alphabet { "#[]\x98\x9c\npprrddoo. abq" };
+    inline std::string randomScript(std::mt19937& engine, std::size_t length, std::string_view alphabet = Alphabet) {
+        std::string result(length, ' ');
+        for (auto& c : result) {
+            c = alphabet[engine() % alphabet.size()];
+        }
+        return result;
+    }
+    /**
+     * @return true if both outcomes are the same, otherwise the first difference is reported
+     */
+    inline bool expectSame(std::string_view what, const Outcome& expected, const Outcome& actual) {
+        auto compare = [what](std::string_view part, const std::string& left, const std::string& right) {
+            if (left == right) {
+                return true;
+            }
+            auto [at, _] = std::mismatch(left.begin(), left.end(), right.begin(), right.end());
+            auto offset = static_cast<std::size_t>(at - left.begin());
+            auto from = offset < 40 ? 0 : offset - 40;
+            std::cerr << what << ": " << part << " differs at " << offset << "\n  expected: ..." << std::string_view { left }.substr(from, 80)
+                      << "\n  actual:   ..." << std::string_view { right }.substr(from, 80) << '\n';
+            return false;
+        };
+        return compare("output", expected.output, actual.output) &
+               compare("data stack", expected.dataStack, actual.dataStack) &
+               compare("trace", expected.trace, actual.trace);
+    }
+} // end namespace Deception::Testing
+#endif //DECEPTION_TEST_DIFFERENTIAL_H
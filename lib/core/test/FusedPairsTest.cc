@@ -0,0 +1,119 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Runs the same scripts with and without fused pairs, fusing must never change what a script does
+#include <core/test/Differential.h>
+using namespace Deception;
+using namespace Deception::Testing;
+namespace {
+    /**
+     * Pairs which straddle a table switch, the second character has to be looked up in the table the first one
+     * switched to
+     */
+    PairProfile tableSwitchPairs() {
+        PairProfile profile;
+        profile.record(Core, '[', ']');
+        profile.record(Core, '[', 'a');
+        profile.record(Nested, ']', '[');
+        profile.record(Nested, ']', 'o');
+        profile.record(Nested, 'a', ']');
+        profile.record(Core, 'o', '[');
+        profile.record(Core, '#', 'a');
+        profile.record(Core, StartString, 'a');
+        profile.record(Core, 'r', 'o');
+        profile.record(Core, 'p', ']');
+        return profile;
+    }
+    bool randomScripts() {
+        std::mt19937 engine { 7 };
+        bool passed = true;
+        for (int round = 0; round < 300 && passed; ++round) {
+            auto script = randomScript(engine, engine() % 400);
+            auto chunk = 1 + engine() % 50;
+            auto plain = makeInterpreter();
+            plain.profilePairs(true);
+            auto expected = runFed(plain, script, chunk);
+            auto fused = makeInterpreter();
+            fused.fuse(plain.getPairProfile(), 64, 1);
+            fused.fuse(tableSwitchPairs(), 64, 1);
+            passed = expectSame("random script " + std::to_string(round), expected, runFed(fused, script, chunk));
+        }
+        return passed;
+    }
+    bool tableSwitches() {
+        const std::string script { "[][]o[a]a][]]o[]#a\n[a][\x98" "a\x9c" "ro[]p]o" };
+        auto plain = makeInterpreter();
+        auto fused = makeInterpreter();
+        fused.fuse(tableSwitchPairs(), 64, 1);
+        return expectSame("table switches", runFed(plain, script, script.size()), runFed(fused, script, script.size()));
+    }
+    bool bufferRefill() {
+        // the pairs sit on either side of the point where the first block of the stream runs out
+        std::string script(InputSource::DefaultBlockSize + 64, 'o');
+        script.replace(InputSource::DefaultBlockSize - 3, 6, "o[][]o");
+        auto run = [&script](bool fuse) {
+            std::istringstream in { script };
+            auto interpreter = makeInterpreter({ std::experimental::make_observer<std::istream>(&in) });
+            if (fuse) {
+                interpreter.fuse(tableSwitchPairs(), 64, 1);
+            }
+            interpreter.run();
+            return capture(interpreter);
+        };
+        // fed input is refilled one feed at a time so a chunk boundary falls between the pairs as well
+        auto plain = makeInterpreter();
+        auto fused = makeInterpreter();
+        fused.fuse(tableSwitchPairs(), 64, 1);
+        return expectSame("stream refill", run(false), run(true)) &
+               expectSame("fed refill", runFed(plain, script, InputSource::DefaultBlockSize - 2), runFed(fused, script, InputSource::DefaultBlockSize - 2));
+    }
+    bool checkpointKeepsPairs() {
+        const std::string first { "[a]o[]r" };
+        const std::string second { "a[]o][a]." };
+        auto plain = makeInterpreter();
+        auto expected = runFed(plain, first + second, first.size());
+        auto fused = makeInterpreter();
+        fused.fuse(tableSwitchPairs(), 64, 1);
+        fused.feed(first);
+        fused.runAvailable();
+        auto branch = fused.checkpoint()->fork();
+        if (branch.getFusedPairs().size() != fused.getFusedPairs().size()) {
+            std::cerr << "checkpoint: the branch has " << branch.getFusedPairs().size() << " fused pairs instead of " << fused.getFusedPairs().size() << '\n';
+            return false;
+        }
+        branch.setOutputSink(OutputSink::memory());
+        auto before = capture(fused);
+        auto after = runFed(branch, second, second.size());
+        after.output = before.output + after.output;
+        return expectSame("checkpoint", expected, after);
+    }
+}
+int main() {
+    bool passed = randomScripts();
+    passed &= tableSwitches();
+    passed &= bufferRefill();
+    passed &= checkpointKeepsPairs();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/*
+deception
+Copyright (c) 2024 and beyond, Joshua Scoggins
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Runs the same scripts as compiled routines and one character at a time, both have to do exactly the same thing
+#include <core/BatchRunner.h>
+#include <core/test/Differential.h>
+using namespace Deception;
+using namespace Deception::Testing;
+namespace {
+    /**
+     * Actions which pull characters through next read the input stack and not the routine, so routines are made of
+     * everything but r
+     */
+    constexpr std::string_view RoutineAlphabet { "#[]\x98\x9c\npdo. abq" };
+    bool randomRoutines() {
+        std::mt19937 engine { 11 };
+        bool passed = true;
+        for (int round = 0; round < 300 && passed; ++round) {
+            auto code = randomScript(engine, engine() % 400, RoutineAlphabet);
+            auto plain = makeInterpreter();
+            plain.feed(code);
+            plain.runAvailable();
+            auto expected = runFed(plain, code, code.size() + 1);
+            auto compiled = makeInterpreter();
+            Interpreter::Routine routine { code };
+            compiled.execute(routine);
+            // the second time through the steps are already compiled, possibly for different tables
+            compiled.execute(routine);
+            compiled.closeInput();
+            compiled.runAvailable();
+            passed = expectSame("routine " + std::to_string(round), expected, capture(compiled));
+        }
+        return passed;
+    }
+    bool preludes() {
+        std::mt19937 engine { 13 };
+        bool passed = true;
+        for (int round = 0; round < 50 && passed; ++round) {
+            auto prelude = randomScript(engine, engine() % 100, RoutineAlphabet);
+            std::vector<BatchJob> jobs;
+            std::vector<BatchJob> joined;
+            for (int job = 0; job < 8; ++job) {
+                auto code = randomScript(engine, engine() % 200);
+                jobs.push_back(BatchJob::code(std::to_string(job), code));
+                joined.push_back(BatchJob::code(std::to_string(job), prelude + code));
+            }
+            BatchRunner compiled { conclave(), { .workers = 2, .entry = Core, .prelude = prelude } };
+            BatchRunner plain { conclave(), { .workers = 2, .entry = Core, .prelude = { } } };
+            auto expected = plain.run(joined);
+            auto actual = compiled.run(jobs);
+            for (std::size_t job = 0; job < jobs.size(); ++job) {
+                Outcome left { expected[job].output, describe(expected[job].dataStack.begin(), expected[job].dataStack.end()), { } };
+                Outcome right { actual[job].output, describe(actual[job].dataStack.begin(), actual[job].dataStack.end()), { } };
+                passed &= expectSame("prelude " + std::to_string(round) + " job " + std::to_string(job), left, right);
+            }
+        }
+        return passed;
+    }
+}
+int main() {
+    bool passed = randomRoutines();
+    passed &= preludes();
+    return passed ? 0 : 1;
+}